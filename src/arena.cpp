@@ -0,0 +1,72 @@
+/**
+ * @file arena.cpp
+ * @brief 内存池的实现
+ */
+
+#include "arena.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace strreg {
+
+Arena::~Arena() {
+  for (Block &block : blocks_) {
+    std::free(block.data);
+  }
+}
+
+void *Arena::allocateSlow(std::size_t size, std::size_t align) {
+  // 依次尝试后面已有的内存块，都放不下时在当前块之后插入一个新块
+  for (std::size_t next = current_ + 1; next < blocks_.size(); ++next) {
+    if (size + align - 1 <= blocks_[next].size) {
+      current_ = next;
+      offset_ = 0;
+      return allocate(size, align);
+    }
+  }
+  std::size_t blockSize = size + align - 1;
+  if (blockSize < kBlockSize) {
+    blockSize = kBlockSize;
+  }
+  char *data = static_cast<char *>(std::malloc(blockSize));
+  if (data == nullptr) {
+    throw std::bad_alloc();
+  }
+  std::size_t position = blocks_.empty() ? 0 : current_ + 1;
+  blocks_.insert(blocks_.begin() + position, Block{data, blockSize});
+  current_ = position;
+  offset_ = 0;
+  return allocate(size, align);
+}
+
+void Arena::reset() {
+  current_ = 0;
+  offset_ = 0;
+  std::size_t retained = 0;
+  std::size_t keep = 0;
+  while (keep < blocks_.size() &&
+         retained + blocks_[keep].size <= kRetainedBytes) {
+    retained += blocks_[keep].size;
+    ++keep;
+  }
+  for (std::size_t i = keep; i < blocks_.size(); ++i) {
+    std::free(blocks_[i].data);
+  }
+  blocks_.resize(keep);
+}
+
+std::size_t Arena::capacity() const {
+  std::size_t total = 0;
+  for (const Block &block : blocks_) {
+    total += block.size;
+  }
+  return total;
+}
+
+Arena &threadArena() {
+  thread_local Arena arena;
+  return arena;
+}
+
+} // namespace strreg
@@ -0,0 +1,148 @@
+/**
+ * @file arena.h
+ * @brief 单调增长、整体回退的内存池
+ *
+ * 片段搜索的中间数据（状态表、结果集合、拼接缓冲区）只在一次查询内有效。
+ * 从内存池中顺序切出这些内存，查询结束时把游标移回起点即可一次性“释放”，
+ * 内存块本身留给下一次查询复用，稳定状态下每次查询不再调用 malloc。
+ */
+
+#ifndef STRREG_ARENA_H
+#define STRREG_ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+namespace strreg {
+
+/**
+ * @brief 内存池
+ * 单个对象不能单独释放；只能回退到先前记录的位置
+ */
+class Arena {
+public:
+  /// 新内存块的默认大小
+  static const std::size_t kBlockSize = 64 * 1024;
+  /// reset 后保留的内存块总大小上限，超出部分归还系统
+  static const std::size_t kRetainedBytes = 1024 * 1024;
+
+  /**
+   * @brief 内存池中的一个位置
+   */
+  struct Mark {
+    std::size_t block = 0;
+    std::size_t offset = 0;
+  };
+
+  Arena() = default;
+  ~Arena();
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  /**
+   * @brief 分配一段内存
+   * @param size 字节数
+   * @param align 对齐，必须是2的幂
+   * @return 内存地址，在回退到更早的位置之前一直有效
+   */
+  void *allocate(std::size_t size, std::size_t align) {
+    if (current_ < blocks_.size()) {
+      Block &block = blocks_[current_];
+      std::size_t offset = (offset_ + align - 1) & ~(align - 1);
+      if (offset + size <= block.size) {
+        offset_ = offset + size;
+        return block.data + offset;
+      }
+    }
+    return allocateSlow(size, align);
+  }
+
+  /// 当前位置
+  Mark mark() const { return Mark{current_, offset_}; }
+
+  /// 回退到 mark，之后分配的内存全部失效
+  void rewind(Mark mark) {
+    current_ = mark.block;
+    offset_ = mark.offset;
+  }
+
+  /// 回退到起点，并把超过 kRetainedBytes 的内存块归还系统
+  void reset();
+
+  /// 已向系统申请的总字节数
+  std::size_t capacity() const;
+
+private:
+  struct Block {
+    char *data;
+    std::size_t size;
+  };
+
+  void *allocateSlow(std::size_t size, std::size_t align);
+
+  std::vector<Block> blocks_;
+  std::size_t current_ = 0;
+  std::size_t offset_ = 0;
+};
+
+/**
+ * @brief 作用域内的内存池使用
+ * 析构时回退到构造时的位置；最外层作用域析构时调用 reset
+ */
+class ArenaScope {
+public:
+  explicit ArenaScope(Arena &arena) : arena_(arena), mark_(arena.mark()) {}
+  ~ArenaScope() {
+    if (mark_.block == 0 && mark_.offset == 0) {
+      arena_.reset();
+    } else {
+      arena_.rewind(mark_);
+    }
+  }
+  ArenaScope(const ArenaScope &) = delete;
+  ArenaScope &operator=(const ArenaScope &) = delete;
+
+private:
+  Arena &arena_;
+  Arena::Mark mark_;
+};
+
+/**
+ * @brief 从内存池分配的标准库分配器
+ * deallocate 不做任何事，内存在内存池回退时统一回收
+ */
+template <class T> class ArenaAllocator {
+public:
+  using value_type = T;
+
+  explicit ArenaAllocator(Arena &arena) : arena_(&arena) {}
+  template <class U>
+  ArenaAllocator(const ArenaAllocator<U> &other) : arena_(other.arena()) {}
+
+  T *allocate(std::size_t n) {
+    return static_cast<T *>(arena_->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T *, std::size_t) {}
+
+  Arena *arena() const { return arena_; }
+
+  template <class U> bool operator==(const ArenaAllocator<U> &other) const {
+    return arena_ == other.arena();
+  }
+  template <class U> bool operator!=(const ArenaAllocator<U> &other) const {
+    return arena_ != other.arena();
+  }
+
+private:
+  Arena *arena_;
+};
+
+/**
+ * @brief 当前线程的内存池
+ * 同一线程内的查询依次复用它，不同线程互不影响
+ */
+Arena &threadArena();
+
+} // namespace strreg
+
+#endif // STRREG_ARENA_H
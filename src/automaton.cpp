@@ -0,0 +1,136 @@
+/**
+ * @file automaton.cpp
+ * @brief 组合自动机扫描器的实现
+ */
+
+#include "automaton.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace strreg {
+
+namespace {
+
+/// 每个线程同时保留的确定自动机个数，超出时轮流替换
+const std::size_t kThreadSlots = 4;
+
+std::atomic<std::uint64_t> nextScannerId{1};
+
+} // namespace
+
+AutomatonScanner::AutomatonScanner(const std::vector<FixedMatcher> &matchers)
+    : matchers_(matchers),
+      id_(nextScannerId.fetch_add(1, std::memory_order_relaxed)) {
+  if (matchers_.size() > kMaxRules) {
+    matchers_.resize(kMaxRules);
+  }
+  std::size_t bits = 0;
+  for (const FixedMatcher &m : matchers_) {
+    maxLength_ = std::max(maxLength_, m.length());
+    bits += m.length();
+  }
+  words_ = std::max<std::size_t>(1, (bits + 63) / 64);
+  byteMasks_.assign(256 * words_, 0);
+  startMask_.assign(words_, 0);
+
+  // 规则 r 的第 p 位占状态位 base + p，左移一位即前进到下一位
+  std::size_t base = 0;
+  for (const FixedMatcher &m : matchers_) {
+    startMask_[base / 64] |= std::uint64_t(1) << (base % 64);
+    for (std::size_t pos = 0; pos < m.length(); ++pos) {
+      std::size_t bit = base + pos;
+      for (unsigned c = 0; c < 256; ++c) {
+        if (m.allows(pos, static_cast<unsigned char>(c))) {
+          byteMasks_[c * words_ + bit / 64] |= std::uint64_t(1) << (bit % 64);
+        }
+      }
+    }
+    base += m.length();
+    finalBit_.push_back(base - 1);
+  }
+}
+
+AutomatonScanner::Dfa &AutomatonScanner::threadDfa() const {
+  struct Slot {
+    std::uint64_t id = 0;
+    std::unique_ptr<Dfa> dfa;
+  };
+  thread_local Slot slots[kThreadSlots];
+  thread_local std::size_t victim = 0;
+
+  for (Slot &slot : slots) {
+    if (slot.id == id_) {
+      return *slot.dfa;
+    }
+  }
+  Slot &slot = slots[victim];
+  victim = (victim + 1) % kThreadSlots;
+  if (!slot.dfa) {
+    slot.dfa = std::make_unique<Dfa>();
+  }
+  slot.id = id_;
+  resetDfa(*slot.dfa);
+  return *slot.dfa;
+}
+
+void AutomatonScanner::resetDfa(Dfa &dfa) const {
+  dfa.sets.clear();
+  dfa.next.clear();
+  dfa.accept.clear();
+  dfa.index.clear();
+  std::vector<std::uint64_t> empty(words_, 0);
+  addState(dfa, empty.data());
+}
+
+std::int32_t AutomatonScanner::addState(Dfa &dfa,
+                                        const std::uint64_t *set) const {
+  std::string key(reinterpret_cast<const char *>(set),
+                  words_ * sizeof(std::uint64_t));
+  auto it = dfa.index.find(key);
+  if (it != dfa.index.end()) {
+    return it->second;
+  }
+  std::int32_t id = static_cast<std::int32_t>(dfa.accept.size());
+  std::uint32_t accept = 0;
+  for (std::size_t r = 0; r < finalBit_.size(); ++r) {
+    std::size_t bit = finalBit_[r];
+    if ((set[bit / 64] >> (bit % 64)) & 1u) {
+      accept |= std::uint32_t(1) << r;
+    }
+  }
+  dfa.sets.insert(dfa.sets.end(), set, set + words_);
+  dfa.next.resize(dfa.next.size() + 256, -1);
+  dfa.accept.push_back(accept);
+  dfa.index.emplace(std::move(key), id);
+  return id;
+}
+
+std::int32_t AutomatonScanner::extend(Dfa &dfa, std::int32_t state,
+                                      unsigned char c) const {
+  // D' = ((D << 1) | start) & B[c]，逐个64位字计算，进位来自低一个字的最高位
+  std::uint64_t set[(kMaxRules * FixedMatcher::kMaxLength + 63) / 64];
+  const std::uint64_t *from = &dfa.sets[state * words_];
+  const std::uint64_t *mask = &byteMasks_[c * words_];
+  std::uint64_t carry = 0;
+  for (std::size_t w = 0; w < words_; ++w) {
+    set[w] = ((from[w] << 1) | carry | startMask_[w]) & mask[w];
+    carry = from[w] >> 63;
+  }
+
+  if (dfa.accept.size() >= kMaxStates) {
+    // 状态过多时整表清空，只保留空状态和目标状态，扫描从目标状态继续
+    resetDfa(dfa);
+    return addState(dfa, set);
+  }
+  std::int32_t target = addState(dfa, set);
+  dfa.next[static_cast<std::size_t>(state) * 256 + c] = target;
+  return target;
+}
+
+std::size_t AutomatonScanner::cachedStates() const {
+  return threadDfa().accept.size();
+}
+
+} // namespace strreg
@@ -0,0 +1,161 @@
+/**
+ * @file automaton.h
+ * @brief 多规则、多年份的组合自动机扫描器
+ *
+ * 把所有参与扫描的定长规则放进同一个位并行的非确定自动机：每条规则的每一位
+ * 占一个状态位，读入一个字节时整体左移一位、置上各规则的起始位，再与该字节
+ * 允许的位掩码相与。非确定自动机的状态集合按需转换成确定自动机的状态并缓存，
+ * 稳定后每个字节只是一次查表，耗时与规则条数和年份个数无关。
+ *
+ * 确定自动机的状态表在扫描时增长，因此每个线程各有一份，扫描器本身可以在
+ * 多个线程中同时使用。
+ */
+
+#ifndef STRREG_AUTOMATON_H
+#define STRREG_AUTOMATON_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "fixed_matcher.h"
+#include "validator.h"
+#include "window_scanner.h"
+
+namespace strreg {
+
+/**
+ * @brief 组合自动机扫描器
+ * 回调的规则序号、偏移和顺序与 WindowScanner::scan 完全相同
+ */
+class AutomatonScanner {
+public:
+  /// 一个扫描器最多包含的规则数
+  static const std::size_t kMaxRules = 32;
+  /// 每个线程缓存的确定自动机状态数上限，超出时清空重建
+  static const std::size_t kMaxStates = 4096;
+
+  /**
+   * @brief 由若干匹配器构造扫描器
+   * @param matchers 参与扫描的匹配器，回调中的规则序号即其下标
+   */
+  explicit AutomatonScanner(const std::vector<FixedMatcher> &matchers);
+
+  /**
+   * @brief 扫描缓冲区，按偏移从小到大（同一偏移按规则序号）回调每个匹配
+   * @param data 缓冲区起始地址
+   * @param len 缓冲区长度
+   * @param fn 回调 bool fn(std::size_t rule, std::size_t offset)，
+   *           返回false时立即停止扫描
+   */
+  template <class Fn> void scan(const char *data, std::size_t len, Fn fn) const;
+
+  std::size_t ruleCount() const { return matchers_.size(); }
+  const FixedMatcher &matcher(std::size_t rule) const {
+    return matchers_[rule];
+  }
+  std::size_t maxLength() const { return maxLength_; }
+
+  /// 当前线程为该扫描器缓存的确定自动机状态数，用于诊断
+  std::size_t cachedStates() const;
+
+private:
+  /**
+   * @brief 一个线程的确定自动机缓存
+   * 状态0是空集合；next[s * 256 + c] 为负表示尚未计算
+   */
+  struct Dfa {
+    std::vector<std::uint64_t> sets;
+    std::vector<std::int32_t> next;
+    std::vector<std::uint32_t> accept;
+    std::unordered_map<std::string, std::int32_t> index;
+  };
+
+  Dfa &threadDfa() const;
+  void resetDfa(Dfa &dfa) const;
+  /// 把状态集合加入缓存（已存在时返回原编号）
+  std::int32_t addState(Dfa &dfa, const std::uint64_t *set) const;
+  /// 计算并缓存 state 读入字节 c 后的状态
+  std::int32_t extend(Dfa &dfa, std::int32_t state, unsigned char c) const;
+
+  std::vector<FixedMatcher> matchers_;
+  std::size_t maxLength_ = 0;
+  std::size_t words_ = 0;
+  std::vector<std::uint64_t> byteMasks_;  ///< 256 × words_
+  std::vector<std::uint64_t> startMask_;  ///< 各规则第0位
+  std::vector<std::size_t> finalBit_;     ///< 各规则最后一位的状态位
+  std::uint64_t id_;                      ///< 全进程唯一，用于线程缓存
+};
+
+/**
+ * @brief 按进程默认引擎扫描：Engine::Automaton 时使用扫描器对应的组合
+ * 自动机，否则使用 WindowScanner::scan，回调的内容和顺序相同
+ */
+template <class Fn>
+void scanWindows(const WindowScanner &scanner, const char *data,
+                 std::size_t len, Fn fn) {
+  if (defaultEngine() == Engine::Automaton) {
+    scanner.automaton().scan(data, len, fn);
+  } else {
+    scanner.scan(data, len, fn);
+  }
+}
+
+template <class Fn>
+void AutomatonScanner::scan(const char *data, std::size_t len, Fn fn) const {
+  Dfa &dfa = threadDfa();
+  const std::size_t m = maxLength_;
+  // 自动机在匹配的末尾报告，不同长度的规则末尾顺序与起点顺序不同；
+  // 按起点暂存（m 不超过环的大小，未回调的起点互不冲突），
+  // 起点之后 m 个字节内不会再有新的匹配，届时按序回调
+  const std::size_t kRing = FixedMatcher::kMaxLength;
+  static_assert((kRing & (kRing - 1)) == 0, "环的大小须为2的幂");
+  std::uint32_t pending[kRing] = {};
+  auto flush = [&](std::size_t start) {
+    std::uint32_t &rules = pending[start & (kRing - 1)];
+    while (rules != 0) {
+      unsigned r = lowestBit(rules);
+      rules &= rules - 1;
+      if (!fn(r, start)) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  // 状态表只在 extend 中增长，之后重新取地址
+  const std::int32_t *table = dfa.next.data();
+  const std::uint32_t *accepts = dfa.accept.data();
+  std::int32_t state = 0;
+  for (std::size_t i = 0; i < len; ++i) {
+    const unsigned char c = static_cast<unsigned char>(data[i]);
+    std::int32_t next = table[static_cast<std::size_t>(state) * 256 + c];
+    if (next < 0) {
+      next = extend(dfa, state, c);
+      table = dfa.next.data();
+      accepts = dfa.accept.data();
+    }
+    state = next;
+    std::uint32_t accept = accepts[state];
+    while (accept != 0) {
+      unsigned r = lowestBit(accept);
+      accept &= accept - 1;
+      pending[(i + 1 - matchers_[r].length()) & (kRing - 1)] |=
+          std::uint32_t(1) << r;
+    }
+    if (i + 1 >= m && !flush(i + 1 - m)) {
+      return;
+    }
+  }
+  for (std::size_t start = len >= m ? len - m + 1 : 0; start < len; ++start) {
+    if (!flush(start)) {
+      return;
+    }
+  }
+}
+
+} // namespace strreg
+
+#endif // STRREG_AUTOMATON_H
@@ -0,0 +1,519 @@
+/**
+ * @file batch.cpp
+ * @brief 流式批处理模式的实现
+ */
+
+#include "batch.h"
+
+#include <charconv>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#include "mapped_scan.h"
+#include "metrics.h"
+#include "pipeline.h"
+#include "stream.h"
+
+namespace strreg {
+
+namespace {
+
+Match wholeRecord(std::size_t length, RuleId rule) {
+  Match match;
+  match.offset = 0;
+  match.length = length;
+  match.rule = rule;
+  return match;
+}
+
+/**
+ * @brief 追加一行结果：记录号\t匹配\t偏移\t规则
+ */
+void formatLine(std::string &out, std::size_t id, std::string_view code,
+                std::size_t offset, std::string_view rule) {
+  char digits[24];
+  std::to_chars_result result =
+      std::to_chars(digits, digits + sizeof(digits), id);
+  out.append(digits, result.ptr);
+  out.push_back('\t');
+  out.append(code.data(), code.size());
+  out.push_back('\t');
+  result = std::to_chars(digits, digits + sizeof(digits), offset);
+  out.append(digits, result.ptr);
+  out.push_back('\t');
+  out.append(rule.data(), rule.size());
+  out.push_back('\n');
+}
+
+void formatMiss(std::string &out, std::size_t id) {
+  char digits[24];
+  std::to_chars_result result =
+      std::to_chars(digits, digits + sizeof(digits), id);
+  out.append(digits, result.ptr);
+  out.append("\tnull\t-1\t-\n");
+}
+
+/**
+ * @brief 用规则文件中的规则处理一条记录
+ */
+void processWithRules(std::string &out, std::size_t id,
+                      std::string_view record, const BatchOptions &options) {
+  const RuleSet &rules = *options.rules;
+  const std::size_t before = out.size();
+  if (options.mode == BatchMode::Validate) {
+    std::size_t rule = rules.validate(record, options.years);
+    if (rule != RuleSet::npos) {
+      STRREG_COUNT(MatchesRuleSet, 1);
+      if (options.sink != nullptr) {
+        options.sink->add(rule, record.data(), id);
+      } else {
+        formatLine(out, id, record, 0, rules.rule(rule).name);
+      }
+    }
+  } else {
+    const bool all = options.mode == BatchMode::FindAll;
+    STRREG_COUNT(BytesScanned, record.length());
+    rules.scan(record, options.years,
+               [&](std::size_t rule, std::size_t offset, std::size_t) {
+                 STRREG_COUNT(MatchesRuleSet, 1);
+                 if (options.sink != nullptr) {
+                   options.sink->add(rule, record.data() + offset, id);
+                 } else {
+                   formatLine(out, id,
+                              record.substr(offset, rules.rule(rule).length()),
+                              offset, rules.rule(rule).name);
+                 }
+                 return all;
+               });
+  }
+  if (out.size() == before && options.sink == nullptr) {
+    formatMiss(out, id);
+  }
+}
+
+/**
+ * @brief 近似匹配一条记录，每个结果一行：记录号\t编码\t偏移\t规则\t替换数
+ */
+void processFuzzy(std::string &out, std::size_t id, std::string_view record,
+                  const BatchOptions &options) {
+  const FuzzyScanner &scanner = *options.fuzzy;
+  auto format = [&](const FuzzyMatch &match) {
+    if (options.sink != nullptr) {
+      options.sink->add(static_cast<std::size_t>(match.match.rule),
+                        match.corrected, id);
+      return;
+    }
+    formatLine(out, id, match.correction(), match.match.offset,
+               ruleName(match.match.rule));
+    out.back() = '\t';
+    char digits[24];
+    std::to_chars_result result =
+        std::to_chars(digits, digits + sizeof(digits), match.cost);
+    out.append(digits, result.ptr);
+    out.push_back('\n');
+  };
+
+  if (options.mode == BatchMode::FindAll) {
+    thread_local std::vector<FuzzyMatch> matches;
+    matches.clear();
+    scanner.findAll(record, matches);
+    for (const FuzzyMatch &match : matches) {
+      format(match);
+    }
+    if (!matches.empty()) {
+      return;
+    }
+  } else {
+    FuzzyMatch match = options.mode == BatchMode::Validate
+                           ? scanner.validate(record)
+                           : scanner.extract(record);
+    if (match) {
+      format(match);
+      return;
+    }
+  }
+  if (options.sink == nullptr) {
+    formatMiss(out, id);
+    out.back() = '\t';
+    out.append("-\n");
+  }
+}
+
+/**
+ * @brief 输出内置规则的一个结果；去重汇总时交给汇总，未找到时不输出
+ * 汇总中内置规则的序号即 RuleId 的值
+ */
+void emitResult(std::string &out, std::size_t id, std::string_view record,
+                const Match &match, const BatchOptions &options) {
+  if (options.sink == nullptr) {
+    formatResult(out, id, record, match);
+  } else if (match) {
+    options.sink->add(static_cast<std::size_t>(match.rule),
+                      record.data() + match.offset, id);
+  }
+}
+
+bool parseCount(const std::string &text, std::size_t &value) {
+  std::from_chars_result result =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+} // namespace
+
+bool parseBatchArgument(const std::string &arg, BatchOptions &options) {
+  if (arg.compare(0, 10, "--threads=") == 0) {
+    return parseCount(arg.substr(10), options.threads);
+  }
+  if (arg.compare(0, 13, "--chunk-size=") == 0) {
+    return parseCount(arg.substr(13), options.chunkSize) &&
+           options.chunkSize > 0;
+  }
+  if (arg.compare(0, 8, "--rules=") == 0 && arg.length() > 8) {
+    options.rulesFile = arg.substr(8);
+    return true;
+  }
+  if (arg == "--mmap") {
+    options.mapped = true;
+    return true;
+  }
+  if (arg == "--stream") {
+    options.streaming = true;
+    return true;
+  }
+  if (arg == "--mode=validate") {
+    options.mode = BatchMode::Validate;
+    return true;
+  }
+  if (arg == "--mode=extract") {
+    options.mode = BatchMode::Extract;
+    return true;
+  }
+  if (arg == "--mode=find-all") {
+    options.mode = BatchMode::FindAll;
+    return true;
+  }
+  if (arg.compare(0, 8, "--fuzzy=") == 0) {
+    return parseCount(arg.substr(8), options.fuzzyErrors) &&
+           options.fuzzyErrors <= FuzzyScanner::kMaxErrors;
+  }
+  if (arg.compare(0, 13, "--confusions=") == 0) {
+    return options.confusions.parse(std::string_view(arg).substr(13));
+  }
+  if (arg == "--dedup") {
+    options.dedup = true;
+    return true;
+  }
+  if (arg.compare(0, 8, "--dedup=") == 0) {
+    options.dedup = true;
+    return options.dedupOptions.parse(std::string_view(arg).substr(8));
+  }
+  if (arg.compare(0, 7, "--year=") == 0) {
+    return options.years.parse(std::string_view(arg).substr(7));
+  }
+  if (arg.compare(0, 8, "--input=") == 0 && arg.length() > 8) {
+    options.input = arg.substr(8);
+    return true;
+  }
+  return false;
+}
+
+Match processRecord(std::string_view record, const BatchOptions &options) {
+  const YearSet &years = options.years;
+  // 只有一个年份时走单年份接口，遵循 --engine 选择的引擎
+  const bool single = years.size() == 1;
+  const std::string_view year = single ? years.year(0) : std::string_view();
+
+  if (options.family == Family::Xiaoduanmian) {
+    if (options.mode == BatchMode::Validate) {
+      if (!single) {
+        return validate(record, RuleId::Code10, years);
+      }
+      return validate(record, RuleId::Code10, year)
+                 ? wholeRecord(record.length(), RuleId::Code10)
+                 : Match();
+    }
+    return single ? findFirst(record, RuleId::Code10, year)
+                  : findFirst(record, RuleId::Code10, years);
+  }
+
+  if (options.mode == BatchMode::Validate) {
+    if (!single) {
+      Match match = validate(record, RuleId::Code11, years);
+      return match ? match : validate(record, RuleId::Code8, years);
+    }
+    if (validate(record, RuleId::Code11, year)) {
+      return wholeRecord(record.length(), RuleId::Code11);
+    }
+    if (validate(record, RuleId::Code8, year)) {
+      return wholeRecord(record.length(), RuleId::Code8);
+    }
+    return Match();
+  }
+  return single ? extractValid(record, year) : extractValid(record, years);
+}
+
+RecordReader::RecordReader(std::FILE *file, std::size_t bufferSize)
+    : file_(file), buffer_(bufferSize > 0 ? bufferSize : 1), begin_(0),
+      end_(0), eof_(false) {}
+
+bool RecordReader::next(std::string_view &record) {
+  for (;;) {
+    const char *start = buffer_.data() + begin_;
+    const char *newline =
+        static_cast<const char *>(std::memchr(start, '\n', end_ - begin_));
+    std::size_t length;
+    if (newline != nullptr) {
+      length = static_cast<std::size_t>(newline - start);
+      begin_ += length + 1;
+    } else if (eof_ || !refill()) {
+      // 最后一条记录可能没有换行符
+      if (begin_ == end_) {
+        return false;
+      }
+      start = buffer_.data() + begin_;
+      length = end_ - begin_;
+      begin_ = end_;
+    } else {
+      continue;
+    }
+
+    if (length > 0 && start[length - 1] == '\r') {
+      --length;
+    }
+    record = std::string_view(start, length);
+    return true;
+  }
+}
+
+bool RecordReader::refill() {
+  // 未处理的半条记录移到开头；缓冲区已被一条记录占满时扩大一倍
+  if (begin_ > 0) {
+    std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+    end_ -= begin_;
+    begin_ = 0;
+  }
+  if (end_ == buffer_.size()) {
+    buffer_.resize(buffer_.size() * 2);
+  }
+  std::size_t count =
+      std::fread(buffer_.data() + end_, 1, buffer_.size() - end_, file_);
+  end_ += count;
+  if (count == 0) {
+    eof_ = true;
+    return false;
+  }
+  return true;
+}
+
+OutputBuffer::OutputBuffer(std::FILE *file, std::size_t capacity)
+    : file_(file), capacity_(capacity) {
+  buffer_.reserve(capacity_ + 64);
+}
+
+OutputBuffer::~OutputBuffer() { flush(); }
+
+void OutputBuffer::append(std::string_view text) {
+  if (buffer_.size() + text.size() > capacity_) {
+    flush();
+  }
+  buffer_.append(text.data(), text.size());
+}
+
+void OutputBuffer::flush() {
+  if (!buffer_.empty()) {
+    std::fwrite(buffer_.data(), 1, buffer_.size(), file_);
+    buffer_.clear();
+  }
+  std::fflush(file_);
+}
+
+const RuleId *familyRules(Family family, std::size_t &count) {
+  static const RuleId kDaduanmian[] = {RuleId::Code11, RuleId::Code8};
+  static const RuleId kXiaoduanmian[] = {RuleId::Code10};
+  const bool xiao = family == Family::Xiaoduanmian;
+  count = xiao ? 1 : 2;
+  return xiao ? kXiaoduanmian : kDaduanmian;
+}
+
+void formatResult(std::string &out, std::size_t id, std::string_view record,
+                  const Match &match) {
+  if (match) {
+    formatLine(out, id, match.view(record), match.offset,
+               ruleName(match.rule));
+  } else {
+    formatMiss(out, id);
+  }
+}
+
+void processAndFormat(std::string &out, std::size_t id,
+                      std::string_view record, const BatchOptions &options) {
+  STRREG_TIME(Record);
+  STRREG_COUNT(Records, 1);
+  if (options.rules != nullptr) {
+    processWithRules(out, id, record, options);
+    return;
+  }
+  if (options.fuzzy != nullptr) {
+    processFuzzy(out, id, record, options);
+    return;
+  }
+  if (options.mode != BatchMode::FindAll) {
+    emitResult(out, id, record, processRecord(record, options), options);
+    return;
+  }
+
+  std::size_t count;
+  const RuleId *rules = familyRules(options.family, count);
+
+  // 每个线程复用自己的结果数组，热路径上不分配内存
+  thread_local std::vector<Match> matches;
+  matches.clear();
+  if (options.years.size() == 1) {
+    findAll(record, rules, count, options.years.year(0), matches);
+  } else {
+    findAll(record, rules, count, options.years, matches);
+  }
+  if (matches.empty()) {
+    emitResult(out, id, record, Match(), options);
+  }
+  for (const Match &match : matches) {
+    emitResult(out, id, record, match, options);
+  }
+}
+
+namespace {
+
+/**
+ * @brief 按批处理参数构造去重汇总：规则文件中的规则按文件中的序号，
+ * 内置规则按 RuleId 的值
+ */
+std::unique_ptr<DedupSink> makeSink(const BatchOptions &options,
+                                    std::size_t threads) {
+  std::vector<FixedMatcher> matchers;
+  std::vector<std::string> names;
+  if (options.rules != nullptr) {
+    const WindowScanner &scanner = options.rules->scanner(options.years);
+    for (std::size_t r = 0; r < options.rules->size(); ++r) {
+      matchers.push_back(scanner.matcher(r));
+      names.push_back(options.rules->rule(r).name);
+    }
+  } else {
+    for (RuleId rule : {RuleId::Code11, RuleId::Code8, RuleId::Code10}) {
+      matchers.push_back(FixedMatcher::compile(rule, options.years));
+      names.push_back(ruleName(rule));
+    }
+  }
+  const bool parallel = threads > 1 && !options.streaming;
+  return std::make_unique<DedupSink>(matchers, std::move(names),
+                                     options.dedupOptions,
+                                     parallel ? DedupSink::kShards : 1);
+}
+
+/**
+ * @brief 按 --mmap、--stream 或逐行方式处理全部输入
+ */
+int processInput(const BatchOptions &options, std::size_t threads) {
+  if (options.mapped) {
+    return runMappedScan(options, threads);
+  }
+  if (options.streaming) {
+    return runStreamScan(options);
+  }
+
+  std::FILE *file = stdin;
+  if (options.input != "-") {
+    file = std::fopen(options.input.c_str(), "rb");
+    if (file == nullptr) {
+      std::fprintf(stderr, "错误：无法打开输入文件 %s\n",
+                   options.input.c_str());
+      return 1;
+    }
+  }
+
+  if (threads > 1) {
+    runPipeline(file, options, threads);
+  } else {
+    RecordReader reader(file);
+    OutputBuffer out(stdout);
+    std::string line;
+    std::string_view record;
+    std::size_t id = 0;
+    while (reader.next(record)) {
+      line.clear();
+      processAndFormat(line, ++id, record, options);
+      out.append(line);
+    }
+  }
+
+  if (file != stdin) {
+    std::fclose(file);
+  }
+  return 0;
+}
+
+} // namespace
+
+int runBatch(const BatchOptions &batchOptions) {
+  if (batchOptions.years.empty()) {
+    std::fprintf(stderr, "错误：年份必须是两位数字\n");
+    return 1;
+  }
+
+  BatchOptions options = batchOptions;
+  RuleSet rules;
+  if (!options.rulesFile.empty()) {
+    std::string error;
+    if (!rules.load(options.rulesFile, error)) {
+      std::fprintf(stderr, "错误：%s\n", error.c_str());
+      return 1;
+    }
+    if (rules.empty()) {
+      std::fprintf(stderr, "错误：规则文件 %s 中没有规则\n",
+                   options.rulesFile.c_str());
+      return 1;
+    }
+    options.rules = &rules;
+  }
+
+  std::unique_ptr<FuzzyScanner> fuzzy;
+  if (options.fuzzyErrors > 0) {
+    if (options.rules != nullptr || options.mapped || options.streaming) {
+      std::fprintf(stderr, "错误：--fuzzy 不能与 --rules、--mmap 或 --stream "
+                           "同时使用\n");
+      return 1;
+    }
+    std::size_t count;
+    const RuleId *family = familyRules(options.family, count);
+    fuzzy = std::make_unique<FuzzyScanner>(family, count, options.years,
+                                           options.confusions,
+                                           options.fuzzyErrors);
+    options.fuzzy = fuzzy.get();
+  }
+
+  std::size_t threads = options.threads;
+  if (threads == 0) {
+    threads = std::thread::hardware_concurrency();
+  }
+
+  // 去重汇总时各处理路径不输出命中，全部处理完后一次性输出汇总
+  std::unique_ptr<DedupSink> sink;
+  if (options.dedup) {
+    sink = makeSink(options, threads);
+    if (!sink->valid()) {
+      std::fprintf(stderr,
+                   "错误：规则的编码无法压缩为64位，不能使用 --dedup\n");
+      return 1;
+    }
+    options.sink = sink.get();
+  }
+
+  int status = processInput(options, threads);
+  if (status == 0 && sink) {
+    sink->write(stdout);
+  }
+  return status;
+}
+
+} // namespace strreg
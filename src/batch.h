@@ -0,0 +1,201 @@
+/**
+ * @file batch.h
+ * @brief 从文件或标准输入流式读取记录的批处理模式
+ *
+ * 记录以换行分隔。输入按大块读取后在缓冲区内切分，输出先写入缓冲区再整块写出，
+ * 避免逐行 std::getline 和逐行刷新的开销。
+ */
+
+#ifndef STRREG_BATCH_H
+#define STRREG_BATCH_H
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "dedup.h"
+#include "extract.h"
+#include "fuzzy.h"
+#include "rule_spec.h"
+
+namespace strreg {
+
+/**
+ * @brief 规则族：决定批处理使用哪些规则
+ */
+enum class Family {
+  Daduanmian,  ///< 大端面：11位规则，找不到时退回8位规则
+  Xiaoduanmian ///< 小端面：10位规则
+};
+
+/**
+ * @brief 批处理对每条记录做的操作
+ */
+enum class BatchMode {
+  Validate, ///< 整条记录是否符合规则
+  Extract,  ///< 从记录中提取第一个符合规则的子串
+  FindAll   ///< 找出记录中所有符合规则的子串（包括互相重叠的），每个一行
+};
+
+/**
+ * @brief 批处理参数
+ */
+struct BatchOptions {
+  Family family = Family::Daduanmian;
+  BatchMode mode = BatchMode::Extract;
+  YearSet years = YearSet("25"); ///< 接受的年份，--year= 可给出多个年份
+  std::string input = "-"; ///< 输入文件路径，"-" 表示标准输入
+  std::size_t threads = 0; ///< 工作线程数，0表示使用硬件并发数
+  std::size_t chunkSize = 1 << 20; ///< 并行模式下每块的字节数
+  bool mapped = false; ///< 映射整个输入文件并扫描其中内嵌的全部编码
+  bool streaming = false; ///< 按块读取输入并扫描其中内嵌的全部编码
+  std::string rulesFile; ///< 规则文件，非空时用其中的规则代替内置规则
+  const RuleSet *rules = nullptr; ///< 由 runBatch 从 rulesFile 加载
+  std::size_t fuzzyErrors = 0; ///< 允许的最多替换数，0表示精确匹配
+  ConfusionTable confusions = ConfusionTable::ocr(); ///< 近似匹配的混淆表
+  const FuzzyScanner *fuzzy = nullptr; ///< 由 runBatch 按 fuzzyErrors 构造
+  bool dedup = false; ///< 输出去重汇总，代替每个命中一行
+  DedupOptions dedupOptions; ///< --dedup= 给出的汇总格式和统计项
+  DedupSink *sink = nullptr; ///< 由 runBatch 按 dedup 构造
+};
+
+/**
+ * @brief 规则族使用的内置规则
+ * @param family 规则族
+ * @param count 规则个数写入这里
+ * @return 大端面为 {Code11, Code8}，小端面为 {Code10}
+ */
+const RuleId *familyRules(Family family, std::size_t &count);
+
+/**
+ * @brief 解析一个批处理参数
+ * （--mode=、--year=、--input=、--threads=、--chunk-size=、--mmap、--rules=、
+ * --stream、--fuzzy=、--confusions=、--dedup[=]）
+ * @param arg 命令行参数
+ * @param options 解析结果写入的位置
+ * @return 参数属于批处理且合法时返回true
+ */
+bool parseBatchArgument(const std::string &arg, BatchOptions &options);
+
+/**
+ * @brief 按批处理参数处理一条记录
+ * @param record 记录内容（不含换行符）
+ * @param options 批处理参数
+ * @return 匹配在记录中的位置
+ */
+Match processRecord(std::string_view record, const BatchOptions &options);
+
+/**
+ * @brief 大块读取、按换行切分记录的读取器
+ */
+class RecordReader {
+public:
+  /**
+   * @param file 已打开的输入文件
+   * @param bufferSize 初始缓冲区大小，遇到更长的记录时自动扩大
+   */
+  explicit RecordReader(std::FILE *file, std::size_t bufferSize = 1 << 20);
+
+  /**
+   * @brief 读取下一条记录
+   * @param record 指向内部缓冲区的记录视图，下次调用 next 前有效；
+   *               行尾的 \r 会被去掉
+   * @return 读到记录返回true，输入结束返回false
+   */
+  bool next(std::string_view &record);
+
+private:
+  /// 把未处理的数据移到缓冲区开头并读入更多数据，没有更多数据时返回false
+  bool refill();
+
+  std::FILE *file_;
+  std::vector<char> buffer_;
+  std::size_t begin_;
+  std::size_t end_;
+  bool eof_;
+};
+
+/**
+ * @brief 攒满一块再写出的输出缓冲区
+ */
+class OutputBuffer {
+public:
+  explicit OutputBuffer(std::FILE *file, std::size_t capacity = 1 << 20);
+  ~OutputBuffer();
+
+  OutputBuffer(const OutputBuffer &) = delete;
+  OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+  void append(std::string_view text);
+
+  /// 写出缓冲区中的全部内容
+  void flush();
+
+private:
+  std::FILE *file_;
+  std::size_t capacity_;
+  std::string buffer_;
+};
+
+/**
+ * @brief 把一条记录的处理结果格式化为一行追加到 out
+ * 格式：记录号\t匹配\t偏移\t规则，未找到时为 记录号\tnull\t-1\t-
+ *
+ * @param out 输出字符串
+ * @param id 记录号（从1开始）
+ * @param record 记录内容
+ * @param match 处理结果
+ */
+void formatResult(std::string &out, std::size_t id, std::string_view record,
+                  const Match &match);
+
+/**
+ * @brief 按批处理参数处理一条记录，并把结果格式化追加到 out
+ * FindAll 模式下每个匹配一行，其余模式每条记录一行。
+ * 使用规则文件时，Validate 取第一条整体匹配的规则，Extract 取偏移最小的匹配
+ * （同一偏移按规则文件中的顺序），规则列输出规则名称。
+ * 近似匹配时匹配列输出替换后的编码，并多一列替换数。
+ * 去重汇总时不输出，命中交给 options.sink，位置为记录号
+ *
+ * @param out 输出字符串
+ * @param id 记录号（从1开始）
+ * @param record 记录内容
+ * @param options 批处理参数
+ */
+void processAndFormat(std::string &out, std::size_t id,
+                      std::string_view record, const BatchOptions &options);
+
+/**
+ * @brief 对文本块中的每条记录调用 fn(std::string_view record)
+ * 记录以换行分隔，行尾的 \r 会被去掉；末尾没有换行符的残余也算一条记录
+ */
+template <class Fn> void forEachRecord(std::string_view block, Fn fn) {
+  while (!block.empty()) {
+    std::size_t newline = block.find('\n');
+    std::string_view record = block.substr(0, newline);
+    if (!record.empty() && record.back() == '\r') {
+      record.remove_suffix(1);
+    }
+    fn(record);
+    if (newline == std::string_view::npos) {
+      break;
+    }
+    block.remove_prefix(newline + 1);
+  }
+}
+
+/**
+ * @brief 运行批处理：逐条读取记录、处理并把结果写到标准输出
+ * 工作线程数大于1时交给 runPipeline 并行处理；指定 --mmap 时交给
+ * runMappedScan，指定 --stream 时交给 runStreamScan
+ *
+ * @param options 批处理参数
+ * @return 进程退出码，0表示成功
+ */
+int runBatch(const BatchOptions &options);
+
+} // namespace strreg
+
+#endif // STRREG_BATCH_H
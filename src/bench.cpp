@@ -0,0 +1,548 @@
+/**
+ * @file bench.cpp
+ * @brief 验证、提取和片段搜索的吞吐基准（strreg_bench）
+ *
+ * 每个基准在固定种子生成的合成数据上反复调用被测函数，迭代次数逐次加倍，
+ * 直到一轮的耗时达到 --min-time。报告每次调用的耗时、每秒处理的记录数和字节数，
+ * 以及每次调用的内存分配次数（通过替换全局 operator new 统计）。
+ *
+ * 用法：
+ *   strreg_bench [--filter=子串] [--min-time=秒] [--format=table|csv] [--list]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "extract.h"
+#include "fragment_cache.h"
+#include "fragments.h"
+#include "fuzzy.h"
+#include "rule_spec.h"
+#include "validator.h"
+#include "work_stealing.h"
+
+namespace {
+
+/// 进程内的内存分配次数
+std::atomic<std::size_t> allocationCount(0);
+
+} // namespace
+
+void *operator new(std::size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size != 0 ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+using strreg::Engine;
+using strreg::RuleId;
+
+const char *const kYear = "25";
+
+/**
+ * @brief 固定种子的合成数据生成器
+ * 背景字符不含 '5'，因此不会偶然出现以 "25" 开头的编码，命中率完全由参数控制
+ */
+class Generator {
+public:
+  explicit Generator(std::uint64_t seed) : rng_(seed) {}
+
+  /// 长度为 length 的背景字符串
+  std::string noise(std::size_t length) {
+    static const char kAlphabet[] =
+        "012346789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+    std::string text(length, ' ');
+    for (char &c : text) {
+      c = kAlphabet[rng_() % (sizeof(kAlphabet) - 1)];
+    }
+    return text;
+  }
+
+  /// 一个符合规则的编码
+  std::string code(RuleId rule) {
+    std::string text = kYear;
+    text += pick("45679");
+    text += pick("012");
+    text += noise(4);
+    switch (rule) {
+    case RuleId::Code11:
+      text += pick("12345");
+      text += pick("012");
+      text += noise(1);
+      break;
+    case RuleId::Code10:
+      text += pick("ABCDEFG");
+      text += noise(1);
+      break;
+    case RuleId::Code8:
+      break;
+    }
+    return text;
+  }
+
+  /// 以 hitRate 的概率返回 true
+  bool chance(double hitRate) {
+    return std::uniform_real_distribution<double>(0.0, 1.0)(rng_) < hitRate;
+  }
+
+  std::size_t below(std::size_t n) { return n == 0 ? 0 : rng_() % n; }
+
+  std::mt19937_64 &rng() { return rng_; }
+
+private:
+  char pick(const char *chars) {
+    return chars[rng_() % std::char_traits<char>::length(chars)];
+  }
+
+  std::mt19937_64 rng_;
+};
+
+/**
+ * @brief 整串验证的输入：长度等于规则长度，hitRate 的记录符合规则
+ */
+std::vector<std::string> wholeRecords(RuleId rule, double hitRate,
+                                      std::size_t count) {
+  Generator gen(42);
+  std::vector<std::string> records;
+  for (std::size_t i = 0; i < count; ++i) {
+    if (gen.chance(hitRate)) {
+      records.push_back(gen.code(rule));
+    } else {
+      // 未命中的记录以年份开头，迫使引擎检查后续各位
+      std::string miss = kYear + gen.noise(strreg::ruleLength(rule) - 2);
+      records.push_back(miss);
+    }
+  }
+  return records;
+}
+
+/**
+ * @brief 提取的输入：长度为 length，hitRate 的记录在随机位置嵌入一个11位编码
+ */
+std::vector<std::string> embeddedRecords(std::size_t length, double hitRate,
+                                         std::size_t count) {
+  Generator gen(7 + length);
+  std::vector<std::string> records;
+  for (std::size_t i = 0; i < count; ++i) {
+    std::string text = gen.noise(length);
+    RuleId rule = length >= 11 ? RuleId::Code11 : RuleId::Code8;
+    if (gen.chance(hitRate) && length >= 8) {
+      std::string code = gen.code(rule);
+      text.replace(gen.below(length - code.length() + 1), code.length(), code);
+    }
+    records.push_back(std::move(text));
+  }
+  return records;
+}
+
+/**
+ * @brief 片段输入：一个编码切成至多3段，再补充噪声片段到 count 个后打乱
+ */
+std::vector<std::vector<std::string>> fragmentSets(RuleId rule,
+                                                   std::size_t count,
+                                                   std::size_t sets) {
+  Generator gen(1000 + count);
+  std::vector<std::vector<std::string>> result;
+  for (std::size_t s = 0; s < sets; ++s) {
+    std::string code = gen.code(rule);
+    std::vector<std::string> fragments;
+    std::size_t pieces = std::min<std::size_t>(count, 3);
+    std::size_t begin = 0;
+    for (std::size_t p = 0; p < pieces; ++p) {
+      std::size_t end = p + 1 == pieces
+                            ? code.length()
+                            : begin + 1 + gen.below(code.length() - begin -
+                                                    (pieces - p));
+      fragments.push_back(code.substr(begin, end - begin));
+      begin = end;
+    }
+    while (fragments.size() < count) {
+      fragments.push_back(gen.noise(1 + gen.below(4)));
+    }
+    std::shuffle(fragments.begin(), fragments.end(), gen.rng());
+    result.push_back(std::move(fragments));
+  }
+  return result;
+}
+
+/**
+ * @brief 一个基准：每次调用处理一条记录，返回值用于防止调用被优化掉
+ */
+struct Benchmark {
+  std::string name;
+  std::function<std::size_t(std::size_t index)> run; ///< 处理第 index 条记录
+  std::function<std::size_t(std::size_t index)> bytes; ///< 第 index 条的字节数
+  std::size_t records = 1; ///< 输入池中的记录数，按下标循环使用
+  Engine engine = Engine::Table;
+};
+
+struct Result {
+  double nsPerCall = 0;
+  std::size_t iterations = 0;
+  double recordsPerSecond = 0;
+  double bytesPerSecond = 0;
+  double allocationsPerCall = 0;
+};
+
+volatile std::size_t sink;
+
+Result measure(const Benchmark &bench, double minTime) {
+  strreg::setDefaultEngine(bench.engine);
+  // 预热：建立验证器和扫描器缓存，这些一次性开销不计入结果
+  for (std::size_t i = 0; i < std::min<std::size_t>(bench.records, 16); ++i) {
+    sink = sink + bench.run(i);
+  }
+
+  Result result;
+  for (std::size_t iterations = 1;; iterations *= 2) {
+    std::size_t bytes = 0;
+    std::size_t allocationsBefore = allocationCount.load();
+    auto start = std::chrono::steady_clock::now();
+    std::size_t acc = 0;
+    std::size_t index = 0;
+    for (std::size_t i = 0; i < iterations; ++i) {
+      acc += bench.run(index);
+      // 循环使用输入池，避免在计时循环中做取模运算
+      if (++index == bench.records) {
+        index = 0;
+      }
+    }
+    auto stop = std::chrono::steady_clock::now();
+    std::size_t allocations = allocationCount.load() - allocationsBefore;
+    sink = sink + acc;
+    for (std::size_t i = 0; i < std::min(iterations, bench.records); ++i) {
+      bytes += bench.bytes(i);
+    }
+    if (iterations > bench.records) {
+      // 输入池被循环使用，按平均每条的字节数折算
+      bytes = bytes / std::min(iterations, bench.records) * iterations;
+    }
+
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    if (seconds >= minTime || iterations >= (std::size_t(1) << 34)) {
+      result.iterations = iterations;
+      result.nsPerCall = seconds * 1e9 / static_cast<double>(iterations);
+      result.recordsPerSecond = static_cast<double>(iterations) / seconds;
+      result.bytesPerSecond = static_cast<double>(bytes) / seconds;
+      result.allocationsPerCall =
+          static_cast<double>(allocations) / static_cast<double>(iterations);
+      return result;
+    }
+  }
+}
+
+/// 把数值格式化为带 k/M/G 后缀的字符串
+std::string humanize(double value) {
+  const char *suffix = "";
+  if (value >= 1e9) {
+    value /= 1e9;
+    suffix = "G";
+  } else if (value >= 1e6) {
+    value /= 1e6;
+    suffix = "M";
+  } else if (value >= 1e3) {
+    value /= 1e3;
+    suffix = "k";
+  }
+  char text[32];
+  std::snprintf(text, sizeof(text), "%.2f%s", value, suffix);
+  return text;
+}
+
+const char *engineName(Engine engine) {
+  switch (engine) {
+  case Engine::Regex:
+    return "regex";
+  case Engine::Table:
+    return "table";
+  case Engine::Static:
+    return "static";
+  case Engine::Automaton:
+    return "automaton";
+  }
+  return "unknown";
+}
+
+/**
+ * @brief 规则条数可变的声明式规则集合，用于观察吞吐随规则数的变化
+ * 规则由内置规则变化末尾的字符类和长度得到，互不相同
+ */
+struct RuleScan {
+  strreg::RuleSet rules;
+  strreg::YearSet years;
+
+  RuleScan(std::size_t count, const char *yearSpec) {
+    std::string text;
+    for (std::size_t k = 0; k < count; ++k) {
+      text += "rule" + std::to_string(k) + " YY[45679][012]" +
+              std::string(2 + k % 5, '.') + "[" +
+              static_cast<char>('A' + k % 20) + "-Z].\n";
+    }
+    std::string error;
+    rules.parse(text, error);
+    years.parse(yearSpec);
+  }
+};
+
+/**
+ * @brief 注册全部基准
+ * 输入数据由 storage 持有，基准通过下标访问
+ */
+struct Suite {
+  std::vector<Benchmark> benchmarks;
+  std::vector<std::vector<std::string>> records;
+  std::vector<std::vector<std::vector<std::string>>> fragments;
+  std::vector<std::vector<std::vector<std::string_view>>> fragmentViews;
+  /// 片段池在第一轮迭代后全部进入缓存，之后测的是命中路径
+  strreg::FragmentCache fragmentCache;
+  std::vector<std::unique_ptr<RuleScan>> ruleScans;
+  std::vector<std::unique_ptr<strreg::FuzzyScanner>> fuzzyScanners;
+
+  void addValidate(const char *name, RuleId rule) {
+    records.push_back(wholeRecords(rule, 0.5, 4096));
+    const std::vector<std::string> &pool = records.back();
+    for (Engine engine : {Engine::Regex, Engine::Table, Engine::Static}) {
+      Benchmark bench;
+      bench.name = std::string(name) + "/" + engineName(engine) +
+                   "/len:" + std::to_string(strreg::ruleLength(rule));
+      bench.run = [&pool, rule](std::size_t i) {
+        return static_cast<std::size_t>(
+            strreg::validate(pool[i], rule, kYear));
+      };
+      bench.bytes = [&pool](std::size_t i) { return pool[i].size(); };
+      bench.records = pool.size();
+      bench.engine = engine;
+      benchmarks.push_back(bench);
+    }
+  }
+
+  void addExtract(std::size_t length) {
+    // 长输入每条都很大，池中的记录数相应减少
+    std::size_t count = std::max<std::size_t>(4, (std::size_t(1) << 22) /
+                                                     std::max<std::size_t>(
+                                                         length, 1024));
+    records.push_back(embeddedRecords(length, 0.1, count));
+    const std::vector<std::string> &pool = records.back();
+    for (Engine engine : {Engine::Regex, Engine::Table, Engine::Automaton}) {
+      Benchmark bench;
+      bench.name = std::string("extractValidString/") + engineName(engine) +
+                   "/len:" + std::to_string(length);
+      bench.run = [&pool](std::size_t i) {
+        return strreg::extractValid(pool[i], kYear).offset;
+      };
+      bench.bytes = [&pool](std::size_t i) { return pool[i].size(); };
+      bench.records = pool.size();
+      bench.engine = engine;
+      benchmarks.push_back(bench);
+    }
+  }
+
+  void addRuleScan(std::size_t count) {
+    const std::size_t kLength = 1 << 16;
+    records.push_back(embeddedRecords(kLength, 1.0, 16));
+    const std::vector<std::string> &pool = records.back();
+    ruleScans.push_back(std::make_unique<RuleScan>(count, "20-29"));
+    const RuleScan &scan = *ruleScans.back();
+    for (Engine engine : {Engine::Table, Engine::Automaton}) {
+      Benchmark bench;
+      bench.name = std::string("ruleSetScan/") + engineName(engine) +
+                   "/rules:" + std::to_string(count);
+      bench.run = [&pool, &scan](std::size_t i) {
+        std::size_t hits = 0;
+        scan.rules.scan(pool[i], scan.years,
+                        [&](std::size_t, std::size_t, std::size_t) {
+                          ++hits;
+                          return true;
+                        });
+        return hits;
+      };
+      bench.bytes = [&pool](std::size_t i) { return pool[i].size(); };
+      bench.records = pool.size();
+      bench.engine = engine;
+      benchmarks.push_back(bench);
+    }
+  }
+
+  void addFuzzy(std::size_t maxErrors) {
+    const std::size_t kLength = 1 << 16;
+    records.push_back(embeddedRecords(kLength, 1.0, 16));
+    const std::vector<std::string> &pool = records.back();
+    const RuleId rules[] = {RuleId::Code11, RuleId::Code8};
+    fuzzyScanners.push_back(std::make_unique<strreg::FuzzyScanner>(
+        rules, 2, strreg::YearSet(kYear), strreg::ConfusionTable::ocr(),
+        maxErrors));
+    const strreg::FuzzyScanner &scanner = *fuzzyScanners.back();
+    Benchmark bench;
+    bench.name = "extractFuzzy/k:" + std::to_string(maxErrors) +
+                 "/len:" + std::to_string(kLength);
+    bench.run = [&pool, &scanner](std::size_t i) {
+      return scanner.extract(pool[i]).cost;
+    };
+    bench.bytes = [&pool](std::size_t i) { return pool[i].size(); };
+    bench.records = pool.size();
+    benchmarks.push_back(bench);
+  }
+
+  void addFragments(std::size_t count) {
+    for (RuleId rule : {RuleId::Code11, RuleId::Code10}) {
+      fragments.push_back(fragmentSets(rule, count, 256));
+      fragmentViews.emplace_back();
+      for (const std::vector<std::string> &set : fragments.back()) {
+        fragmentViews.back().emplace_back(set.begin(), set.end());
+      }
+      const std::vector<std::vector<std::string_view>> &pool =
+          fragmentViews.back();
+
+      Benchmark bench;
+      bench.records = pool.size();
+      bench.bytes = [&pool](std::size_t i) {
+        std::size_t total = 0;
+        for (std::string_view fragment : pool[i]) {
+          total += fragment.size();
+        }
+        return total;
+      };
+      if (rule == RuleId::Code11) {
+        bench.name = "findValidFromFragments/n:" + std::to_string(count);
+        bench.run = [&pool](std::size_t i) {
+          return strreg::findInFragments(pool[i], kYear).length;
+        };
+        benchmarks.push_back(bench);
+        bench.name =
+            "findValidFromFragments/cached/n:" + std::to_string(count);
+        bench.run = [this, &pool](std::size_t i) {
+          return fragmentCache.find(pool[i], kYear).length;
+        };
+        if (count >= strreg::kParallelFragments) {
+          benchmarks.push_back(bench);
+          bench.name =
+              "findValidFromFragments/parallel/n:" + std::to_string(count);
+          bench.run = [&pool](std::size_t i) {
+            return strreg::findInFragments(pool[i], kYear,
+                                           strreg::defaultPool())
+                .length;
+          };
+        }
+      } else {
+        bench.name = "extractFromFragments/n:" + std::to_string(count);
+        bench.run = [&pool](std::size_t i) {
+          return strreg::extractFromFragments(pool[i], kYear).size();
+        };
+        benchmarks.push_back(bench);
+        // 在线查询只要第一个命中
+        bench.name = "extractFromFragments/first:1/n:" + std::to_string(count);
+        bench.run = [&pool](std::size_t i) {
+          return strreg::extractFromFragments(pool[i], kYear, 1).size();
+        };
+        if (count >= strreg::kParallelFragments) {
+          benchmarks.push_back(bench);
+          bench.name =
+              "extractFromFragments/parallel/n:" + std::to_string(count);
+          bench.run = [&pool](std::size_t i) {
+            return strreg::extractFromFragments(pool[i], kYear,
+                                                strreg::defaultPool())
+                .size();
+          };
+        }
+      }
+      benchmarks.push_back(bench);
+    }
+  }
+};
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::string filter;
+  double minTime = 0.2;
+  bool csv = false;
+  bool list = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg.compare(0, 9, "--filter=") == 0) {
+      filter = arg.substr(9);
+    } else if (arg.compare(0, 11, "--min-time=") == 0) {
+      minTime = std::atof(arg.c_str() + 11);
+    } else if (arg == "--format=csv") {
+      csv = true;
+    } else if (arg == "--format=table") {
+      csv = false;
+    } else if (arg == "--list") {
+      list = true;
+    } else {
+      std::fprintf(stderr, "未知参数：%s\n", arg.c_str());
+      return 1;
+    }
+  }
+
+  Suite suite;
+  // 预先为全部输入池留出空间，基准中保存的引用不会因扩容失效
+  suite.records.reserve(64);
+  suite.fragments.reserve(64);
+  suite.fragmentViews.reserve(64);
+  suite.addValidate("validateString", RuleId::Code11);
+  suite.addValidate("validateString8", RuleId::Code8);
+  for (std::size_t length = 8; length <= (1 << 20); length *= 8) {
+    suite.addExtract(length);
+  }
+  suite.addExtract(1 << 20);
+  for (std::size_t count : {3, 12, 30}) {
+    suite.addRuleScan(count);
+  }
+  for (std::size_t maxErrors : {0, 1, 2}) {
+    suite.addFuzzy(maxErrors);
+  }
+  for (std::size_t count = 2; count <= 12; count += 2) {
+    suite.addFragments(count);
+  }
+
+  if (csv) {
+    std::printf("name,ns_per_call,iterations,records_per_s,bytes_per_s,"
+                "allocs_per_call\n");
+  } else if (!list) {
+    std::printf("%-40s %12s %12s %11s %11s %10s\n", "Benchmark", "Time(ns)",
+                "Iterations", "records/s", "bytes/s", "allocs/op");
+  }
+  for (const Benchmark &bench : suite.benchmarks) {
+    if (bench.name.find(filter) == std::string::npos) {
+      continue;
+    }
+    if (list) {
+      std::printf("%s\n", bench.name.c_str());
+      continue;
+    }
+    Result r = measure(bench, minTime);
+    if (csv) {
+      std::printf("%s,%.3f,%zu,%.0f,%.0f,%.3f\n", bench.name.c_str(),
+                  r.nsPerCall, r.iterations, r.recordsPerSecond,
+                  r.bytesPerSecond, r.allocationsPerCall);
+    } else {
+      std::printf("%-40s %12.1f %12zu %11s %11s %10.2f\n", bench.name.c_str(),
+                  r.nsPerCall, r.iterations,
+                  humanize(r.recordsPerSecond).c_str(),
+                  humanize(r.bytesPerSecond).c_str(), r.allocationsPerCall);
+    }
+    std::fflush(stdout);
+  }
+  return 0;
+}
@@ -1,11 +1,13 @@
 #include <iostream>
-#include <regex>
 #include <string>
+#include <string_view>
 #include <vector>
 
-// 前向声明
-void generatePermutations(const std::vector<std::string> &fragments,
-                          std::vector<std::vector<std::string>> &result);
+#include "batch.h"
+#include "extract.h"
+#include "fragments.h"
+#include "metrics.h"
+#include "validator.h"
 
 /**
  * @brief 使用正则表达式验证11位字符串
@@ -27,19 +29,9 @@ bool validateString(const std::string &str, const std::string &year = "25") {
     return false;
   }
 
-  // 构建正则表达式
-  // ^ 表示开始，$ 表示结束
-  // 使用传入的year参数替代前两位
-  // [45679] 表示第3位只能是4、5、6、7或9
-  // [012] 表示第4位只能是0、1或2
-  // .{4} 表示第5-8位可以是任意字符
-  // [12345] 表示第9位只能是1、2、3、4或5
-  // [012] 表示第10位只能是0、1或2
-  // . 表示第11位可以是任意字符
-  std::string pattern_str = "^" + year + "[45679][012].{4}[12345][012].$";
-  std::regex pattern(pattern_str);
-
-  return std::regex_match(str, pattern);
+  // 正则表达式 ^{year}[45679][012].{4}[12345][012].$ 按 (规则, 年份)
+  // 只编译一次，之后从缓存中取用
+  return strreg::validate(str, strreg::RuleId::Code11, year);
 }
 
 /**
@@ -61,26 +53,14 @@ bool validateString8(const std::string &str, const std::string &year = "25") {
     return false;
   }
 
-  // 如果字符串长度不是8位，直接返回false
-  if (str.length() != 8) {
-    return false;
-  }
-
-  // 构建正则表达式
-  // ^ 表示开始，$ 表示结束
-  // 使用传入的year参数替代前两位
-  // [45679] 表示第3位只能是4、5、6、7或9
-  // [012] 表示第4位只能是0、1或2
-  // .{4} 表示第5-8位可以是任意字符
-  std::string pattern_str = "^" + year + "[45679][012].{4}$";
-  std::regex pattern(pattern_str);
-
-  return std::regex_match(str, pattern);
+  // 正则表达式 ^{year}[45679][012].{4}$ 按 (规则, 年份) 只编译一次
+  return strreg::validate(str, strreg::RuleId::Code8, year);
 }
 
 /**
  * @brief 从输入字符串中提取符合规则的11位或8位子字符串
  * 优先提取符合11位规则的字符串，如果没有符合11位规则的，则尝试提取符合8位规则的
+ * 零分配版本见 strreg::extractValid
  *
  * @param input 输入字符串
  * @param year 指定的年份，默认为"25"
@@ -93,74 +73,14 @@ std::string extractValidString(const std::string &input,
     return "null";
   }
 
-  // 首先尝试提取符合11位规则的字符串
-
-  // 如果字符串长度小于11位，尝试8位规则
-  if (input.length() < 11) {
-    // 如果长度等于8位，则直接验证
-    if (input.length() == 8) {
-      return validateString8(input, year) ? input : "null";
-    }
-    // 如果长度大于8位但小于11位，尝试提取8位子串
-    else if (input.length() > 8) {
-      // 提取所有可能的8位子串并验证
-      for (size_t i = 0; i <= input.length() - 8; ++i) {
-        std::string substr = input.substr(i, 8);
-        if (substr.substr(0, 2) == year && validateString8(substr, year)) {
-          return substr;
-        }
-      }
-    }
-    // 如果什么都没找到，返回"null"
-    return "null";
-  }
-
-  // 如果字符串长度等于11位，则直接验证整个字符串
-  if (input.length() == 11) {
-    if (validateString(input, year)) {
-      return input;
-    }
-    // 如果11位字符串不符合规则，尝试提取8位子串
-    for (size_t i = 0; i <= input.length() - 8; ++i) {
-      std::string substr = input.substr(i, 8);
-      if (substr.substr(0, 2) == year && validateString8(substr, year)) {
-        return substr;
-      }
-    }
-    return "null";
-  }
-
-  // 如果字符串长度大于11位，则先尝试查找符合11位条件的子串
-  // 遍历所有可能的11位子串并验证
-  for (size_t i = 0; i <= input.length() - 11; ++i) {
-    std::string substr = input.substr(i, 11);
-    // 检查子串的前两位是否匹配指定的年份
-    if (substr.substr(0, 2) == year) {
-      // 验证完整的子串
-      if (validateString(substr, year)) {
-        return substr;
-      }
-    }
-  }
-
-  // 如果没有找到符合11位规则的子串，尝试查找符合8位规则的子串
-  for (size_t i = 0; i <= input.length() - 8; ++i) {
-    std::string substr = input.substr(i, 8);
-    // 检查子串的前两位是否匹配指定的年份
-    if (substr.substr(0, 2) == year) {
-      // 验证8位子串
-      if (validateString8(substr, year)) {
-        return substr;
-      }
-    }
-  }
-
-  return "null";
+  strreg::Match match = strreg::extractValid(input, year);
+  return match ? std::string(match.view(input)) : "null";
 }
 
 /**
  * @brief 从多个字符串片段中找出满足正则表达式规则的11位或8位字符串
  * 优先查找符合11位规则的字符串，如果没有则尝试查找符合8位规则的字符串
+ * 零分配版本见 strreg::findInFragments
  *
  * @param fragments 字符串片段数组
  * @param year 指定的年份，默认为"25"
@@ -173,88 +93,9 @@ std::string findValidFromFragments(const std::vector<std::string> &fragments,
     return "null";
   }
 
-  // 首先将所有片段合并成一个完整字符串
-  std::string combined = "";
-  for (const auto &fragment : fragments) {
-    combined += fragment;
-  }
-
-  // 使用extractValidString函数从合并后的字符串中提取有效子串
-  std::string result = extractValidString(combined, year);
-  if (result != "null") {
-    return result;
-  }
-
-  // 尝试不同的片段组合顺序
-  // 这里使用一个简单的方法：从每个可能的起始片段开始，尝试所有可能的组合
-  for (size_t start = 0; start < fragments.size(); ++start) {
-    combined = fragments[start];
-
-    // 创建一个临时数组，包含除起始片段外的所有片段
-    std::vector<std::string> remainingFragments;
-    for (size_t i = 0; i < fragments.size(); ++i) {
-      if (i != start) {
-        remainingFragments.push_back(fragments[i]);
-      }
-    }
-
-    // 递归尝试所有可能的排列组合
-    std::vector<std::vector<std::string>> permutations;
-    generatePermutations(remainingFragments, permutations);
-
-    for (const auto &perm : permutations) {
-      std::string testString = combined;
-      for (const auto &frag : perm) {
-        testString += frag;
-      }
-
-      // 检查当前组合是否包含有效字符串
-      std::string validResult = extractValidString(testString, year);
-      if (validResult != "null") {
-        return validResult;
-      }
-    }
-  }
-
-  return "null";
-}
-
-/**
- * @brief 生成所有可能的排列组合
- *
- * @param fragments 字符串片段数组
- * @param result 结果数组，包含所有可能的排列组合
- */
-void generatePermutations(const std::vector<std::string> &fragments,
-                          std::vector<std::vector<std::string>> &result) {
-  // 如果只有一个元素，直接返回该元素组成的排列
-  if (fragments.size() <= 1) {
-    result.push_back(fragments);
-    return;
-  }
-
-  // 对于每个可能的第一个元素，生成剩余元素的所有排列
-  for (size_t i = 0; i < fragments.size(); ++i) {
-    // 创建一个不包含当前元素的新片段数组
-    std::vector<std::string> remaining;
-    for (size_t j = 0; j < fragments.size(); ++j) {
-      if (j != i) {
-        remaining.push_back(fragments[j]);
-      }
-    }
-
-    // 递归生成剩余元素的所有排列
-    std::vector<std::vector<std::string>> subPermutations;
-    generatePermutations(remaining, subPermutations);
-
-    // 将当前元素添加到每个子排列的开头
-    for (const auto &perm : subPermutations) {
-      std::vector<std::string> newPerm;
-      newPerm.push_back(fragments[i]);
-      newPerm.insert(newPerm.end(), perm.begin(), perm.end());
-      result.push_back(newPerm);
-    }
-  }
+  std::vector<std::string_view> views(fragments.begin(), fragments.end());
+  strreg::Code code = strreg::findInFragments(views, year);
+  return code ? std::string(code.view()) : "null";
 }
 
 /**
@@ -286,9 +127,42 @@ findValidFromFragmentsSimple(const std::vector<std::string> &fragments,
 
 /**
  * @brief 主函数 - 测试正则表达式验证方法
+ * 支持的参数：
+ * - --engine=regex|table|static|automaton 选择验证引擎（默认regex）
+ * - --batch 批处理模式，配合 --mode=validate|extract|find-all、
+ *   --year=YY（或 22-26 这样的年份列表）、--input=FILE（默认标准输入）、
+ *   --threads=N、--chunk-size=BYTES、--mmap、--stream 使用；
+ *   --fuzzy=K 允许至多K处 OCR 混淆替换（混淆表由 --confusions=O0,I1,S5,B8
+ *   给出）
+ * - --metrics=text|json 退出时以及收到 SIGUSR1 时把运行指标写到标准错误
+ *   （构建时需开启 STRREG_METRICS）
  * @return 程序退出状态码
  */
-int main() {
+int main(int argc, char *argv[]) {
+  strreg::BatchOptions options;
+  options.family = strreg::Family::Daduanmian;
+  bool batch = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    strreg::Engine engine;
+    if (arg.compare(0, 9, "--engine=") == 0 &&
+        strreg::parseEngine(arg.substr(9), engine)) {
+      strreg::setDefaultEngine(engine);
+    } else if (arg == "--batch") {
+      batch = true;
+    } else if (strreg::metrics::parseArgument(arg)) {
+      // 退出时或收到 SIGUSR1 时写出指标
+    } else if (!strreg::parseBatchArgument(arg, options)) {
+      std::cerr << "未知参数：" << arg << std::endl;
+      return 1;
+    }
+  }
+
+  // 批处理模式：从文件或标准输入逐条读取记录
+  if (batch) {
+    return strreg::runBatch(options);
+  }
+
   // 测试样例 - 使用默认年份"25"
   std::string valid = "25501234102";    // 有效字符串
   std::string invalid1 = "2550123410";  // 长度不够11位
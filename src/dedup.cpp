@@ -0,0 +1,312 @@
+/**
+ * @file dedup.cpp
+ * @brief 去重汇总的实现
+ */
+
+#include "dedup.h"
+
+#include <algorithm>
+
+namespace strreg {
+
+namespace {
+
+/// 初始槽数为 2^kInitialBits
+const unsigned kInitialBits = 10;
+
+/// 键的哈希值：高位用作槽下标，低位用作分片下标
+std::uint64_t mix(std::uint64_t key) {
+  key ^= key >> 30;
+  key *= 0xbf58476d1ce4e5b9ULL;
+  key ^= key >> 27;
+  key *= 0x94d049bb133111ebULL;
+  return key ^ (key >> 31);
+}
+
+void putLittle(std::string &out, std::uint64_t value, std::size_t bytes) {
+  for (std::size_t i = 0; i < bytes; ++i) {
+    out.push_back(static_cast<char>(value >> (8 * i) & 0xff));
+  }
+}
+
+/// 按 CSV 规则写一个字段：含逗号或引号时加引号，引号写两次
+void putCsvField(std::string &out, std::string_view field) {
+  if (field.find_first_of(",\"") == std::string_view::npos) {
+    out.append(field.data(), field.size());
+    return;
+  }
+  out.push_back('"');
+  for (char c : field) {
+    if (c == '"') {
+      out.push_back('"');
+    }
+    out.push_back(c);
+  }
+  out.push_back('"');
+}
+
+} // namespace
+
+CodePacker::CodePacker(const std::vector<FixedMatcher> &matchers)
+    : layouts_(matchers.size()) {
+  // 键从0开始依次分给各规则；总数须小于 kNoKey
+  std::uint64_t next = 0;
+  for (std::size_t r = 0; r < matchers.size(); ++r) {
+    const FixedMatcher &m = matchers[r];
+    Layout &layout = layouts_[r];
+    layout.base = next;
+    layout.length = m.length();
+    for (std::size_t pos = 0; pos < m.length(); ++pos) {
+      std::uint16_t count = 0;
+      for (unsigned c = 0; c < 256; ++c) {
+        if (m.allows(pos, static_cast<unsigned char>(c))) {
+          layout.rank[pos][c] = static_cast<std::uint8_t>(count);
+          layout.bytes[pos][count] = static_cast<std::uint8_t>(c);
+          ++count;
+        }
+      }
+      layout.radix[pos] = std::max<std::uint16_t>(count, 1);
+      if (layout.size > kNoKey / layout.radix[pos]) {
+        valid_ = false;
+        return;
+      }
+      layout.size *= layout.radix[pos];
+    }
+    if (layout.size > kNoKey - next) {
+      valid_ = false;
+      return;
+    }
+    next += layout.size;
+  }
+}
+
+std::uint64_t CodePacker::pack(std::size_t rule, const char *code) const {
+  const Layout &layout = layouts_[rule];
+  std::uint64_t value = 0;
+  for (std::size_t pos = 0; pos < layout.length; ++pos) {
+    value = value * layout.radix[pos] +
+            layout.rank[pos][static_cast<unsigned char>(code[pos])];
+  }
+  return layout.base + value;
+}
+
+std::size_t CodePacker::unpack(std::uint64_t key, char *code,
+                               std::size_t &rule) const {
+  rule = 0;
+  while (rule + 1 < layouts_.size() && key >= layouts_[rule + 1].base) {
+    ++rule;
+  }
+  const Layout &layout = layouts_[rule];
+  std::uint64_t value = key - layout.base;
+  for (std::size_t pos = layout.length; pos-- > 0;) {
+    code[pos] = static_cast<char>(layout.bytes[pos][value % layout.radix[pos]]);
+    value /= layout.radix[pos];
+  }
+  return layout.length;
+}
+
+CodeSet::CodeSet(bool counts, bool positions)
+    : countsEnabled_(counts), positionsEnabled_(positions) {
+  shift_ = 64 - kInitialBits;
+  keys_.assign(std::size_t(1) << kInitialBits, CodePacker::kNoKey);
+  if (countsEnabled_) {
+    counts_.assign(keys_.size(), 0);
+  }
+  if (positionsEnabled_) {
+    firsts_.assign(keys_.size(), 0);
+  }
+}
+
+bool CodeSet::insert(std::uint64_t key, std::uint64_t position) {
+  const std::size_t mask = keys_.size() - 1;
+  std::size_t slot = static_cast<std::size_t>(mix(key) >> shift_);
+  while (keys_[slot] != key) {
+    if (keys_[slot] == CodePacker::kNoKey) {
+      // 负载超过一半时扩容，线性探测的链保持很短
+      if ((size_ + 1) * 2 > keys_.size()) {
+        grow();
+        return insert(key, position);
+      }
+      keys_[slot] = key;
+      if (countsEnabled_) {
+        counts_[slot] = 1;
+      }
+      if (positionsEnabled_) {
+        firsts_[slot] = position;
+      }
+      ++size_;
+      return true;
+    }
+    slot = (slot + 1) & mask;
+  }
+  if (countsEnabled_) {
+    ++counts_[slot];
+  }
+  if (positionsEnabled_) {
+    firsts_[slot] = std::min(firsts_[slot], position);
+  }
+  return false;
+}
+
+void CodeSet::grow() {
+  std::vector<std::uint64_t> keys = std::move(keys_);
+  std::vector<std::uint64_t> counts = std::move(counts_);
+  std::vector<std::uint64_t> firsts = std::move(firsts_);
+  --shift_;
+  keys_.assign(keys.size() * 2, CodePacker::kNoKey);
+  counts_.assign(counts.size() * 2, 0);
+  firsts_.assign(firsts.size() * 2, 0);
+
+  const std::size_t mask = keys_.size() - 1;
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    if (keys[i] == CodePacker::kNoKey) {
+      continue;
+    }
+    std::size_t slot = static_cast<std::size_t>(mix(keys[i]) >> shift_);
+    while (keys_[slot] != CodePacker::kNoKey) {
+      slot = (slot + 1) & mask;
+    }
+    keys_[slot] = keys[i];
+    if (countsEnabled_) {
+      counts_[slot] = counts[i];
+    }
+    if (positionsEnabled_) {
+      firsts_[slot] = firsts[i];
+    }
+  }
+}
+
+bool DedupOptions::parse(std::string_view spec) {
+  DedupOptions options;
+  bool format = false;
+  while (!spec.empty()) {
+    std::size_t comma = spec.find(',');
+    std::string_view item = spec.substr(0, comma);
+    if (item == "csv" && !format) {
+      options.format = DedupFormat::Csv;
+      format = true;
+    } else if (item == "binary" && !format) {
+      options.format = DedupFormat::Binary;
+      format = true;
+    } else if (item == "count") {
+      options.counts = true;
+    } else if (item == "first") {
+      options.positions = true;
+    } else {
+      return false;
+    }
+    if (comma == std::string_view::npos) {
+      break;
+    }
+    spec.remove_prefix(comma + 1);
+  }
+  *this = options;
+  return true;
+}
+
+DedupSink::DedupSink(const std::vector<FixedMatcher> &matchers,
+                     std::vector<std::string> names,
+                     const DedupOptions &options, std::size_t shards)
+    : packer_(matchers), names_(std::move(names)), options_(options) {
+  // 分片数取2的幂，用哈希值的低位选分片
+  std::size_t count = 1;
+  while (count < shards && count < kShards) {
+    count *= 2;
+  }
+  for (std::size_t i = 0; i < count; ++i) {
+    shards_.push_back(std::make_unique<Shard>(options_));
+  }
+}
+
+void DedupSink::add(std::size_t rule, const char *code,
+                    std::uint64_t position) {
+  const std::uint64_t key = packer_.pack(rule, code);
+  Shard &shard = *shards_[mix(key) & (shards_.size() - 1)];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  shard.set.insert(key, position);
+}
+
+std::size_t DedupSink::size() const {
+  std::size_t total = 0;
+  for (const std::unique_ptr<Shard> &shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    total += shard->set.size();
+  }
+  return total;
+}
+
+void DedupSink::write(std::FILE *file) const {
+  struct Entry {
+    std::uint64_t key;
+    std::uint64_t count;
+    std::uint64_t first;
+  };
+  std::vector<Entry> entries;
+  entries.reserve(size());
+  for (const std::unique_ptr<Shard> &shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    shard->set.forEach(
+        [&](std::uint64_t key, std::uint64_t count, std::uint64_t first) {
+          entries.push_back(Entry{key, count, first});
+        });
+  }
+  // 各分片的遍历顺序与线程调度无关，排序后输出是确定的
+  std::sort(entries.begin(), entries.end(),
+            [&](const Entry &a, const Entry &b) {
+              if (options_.positions && a.first != b.first) {
+                return a.first < b.first;
+              }
+              return a.key < b.key;
+            });
+
+  std::string out;
+  const bool binary = options_.format == DedupFormat::Binary;
+  if (binary) {
+    out.append("STRREGD1", 8);
+    putLittle(out, (options_.counts ? 1u : 0u) | (options_.positions ? 2u : 0u),
+              4);
+    putLittle(out, entries.size(), 8);
+  } else {
+    out.append("code,rule");
+    out.append(options_.counts ? ",count" : "");
+    out.append(options_.positions ? ",first" : "");
+    out.push_back('\n');
+  }
+  char code[FixedMatcher::kMaxLength];
+  for (const Entry &entry : entries) {
+    std::size_t rule;
+    std::size_t length = packer_.unpack(entry.key, code, rule);
+    if (binary) {
+      putLittle(out, rule, 1);
+      putLittle(out, length, 1);
+      out.append(code, length);
+      if (options_.counts) {
+        putLittle(out, entry.count, 8);
+      }
+      if (options_.positions) {
+        putLittle(out, entry.first, 8);
+      }
+    } else {
+      putCsvField(out, std::string_view(code, length));
+      out.push_back(',');
+      putCsvField(out, names_[rule]);
+      if (options_.counts) {
+        out.push_back(',');
+        out.append(std::to_string(entry.count));
+      }
+      if (options_.positions) {
+        out.push_back(',');
+        out.append(std::to_string(entry.first));
+      }
+      out.push_back('\n');
+    }
+    if (out.size() >= (1 << 20)) {
+      std::fwrite(out.data(), 1, out.size(), file);
+      out.clear();
+    }
+  }
+  std::fwrite(out.data(), 1, out.size(), file);
+  std::fflush(file);
+}
+
+} // namespace strreg
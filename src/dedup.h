@@ -0,0 +1,202 @@
+/**
+ * @file dedup.h
+ * @brief 提取结果的去重汇总
+ *
+ * 同一个编码在大量记录中反复出现时，逐条输出每个命中既占存储又占带宽。
+ * 去重汇总把每个编码按规则逐位的字符类压缩成一个64位整数（第 p 位的字节
+ * 换成它在该位允许的字节中的序号，再按混合进制拼起来），放进开放寻址的
+ * 哈希集合，可选地统计出现次数和首次出现的位置，最后一次性输出 CSV 或
+ * 二进制汇总。并行模式使用按键分片、每片一把锁的集合。
+ */
+
+#ifndef STRREG_DEDUP_H
+#define STRREG_DEDUP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "fixed_matcher.h"
+
+namespace strreg {
+
+/**
+ * @brief 把符合规则的定长编码与64位键互相转换
+ * 不同规则的键落在互不相交的区间中，键的大小顺序即 (规则, 编码) 的字典序
+ */
+class CodePacker {
+public:
+  /// 可用作空槽标记、不会被任何编码使用的键
+  static constexpr std::uint64_t kNoKey = ~std::uint64_t(0);
+
+  /**
+   * @brief 由参与去重的规则构造
+   * @param matchers 各规则的匹配器，键中的规则序号即其下标
+   */
+  explicit CodePacker(const std::vector<FixedMatcher> &matchers);
+
+  /// 全部规则的编码都能装进64位时返回true
+  bool valid() const { return valid_; }
+
+  /**
+   * @brief 压缩一个编码
+   * @param rule 规则序号
+   * @param code 符合该规则的编码，长度为规则长度
+   */
+  std::uint64_t pack(std::size_t rule, const char *code) const;
+
+  /**
+   * @brief 还原一个编码
+   * @param key pack 得到的键
+   * @param code 编码写入这里，至少 FixedMatcher::kMaxLength 个字节
+   * @param rule 规则序号写入这里
+   * @return 编码长度
+   */
+  std::size_t unpack(std::uint64_t key, char *code, std::size_t &rule) const;
+
+private:
+  struct Layout {
+    std::uint64_t base = 0; ///< 该规则的第一个键
+    std::uint64_t size = 1; ///< 该规则的键的个数
+    std::size_t length = 0;
+    std::uint16_t radix[FixedMatcher::kMaxLength] = {};
+    std::uint8_t rank[FixedMatcher::kMaxLength][256] = {};  ///< 字节的序号
+    std::uint8_t bytes[FixedMatcher::kMaxLength][256] = {}; ///< 序号的字节
+  };
+
+  std::vector<Layout> layouts_;
+  bool valid_ = true;
+};
+
+/**
+ * @brief 开放寻址（线性探测）的64位键集合
+ * 可选地为每个键记录出现次数和最小的位置
+ */
+class CodeSet {
+public:
+  /**
+   * @param counts 是否统计出现次数
+   * @param positions 是否记录首次出现的位置
+   */
+  CodeSet(bool counts, bool positions);
+
+  /**
+   * @brief 加入一个键
+   * @param key 键，不能是 CodePacker::kNoKey
+   * @param position 这次出现的位置；记录的是所有出现中最小的位置
+   * @return 键是第一次加入时返回true
+   */
+  bool insert(std::uint64_t key, std::uint64_t position);
+
+  std::size_t size() const { return size_; }
+
+  /// 对每个键调用 fn(key, count, first)，未统计的项为0
+  template <class Fn> void forEach(Fn fn) const {
+    for (std::size_t i = 0; i < keys_.size(); ++i) {
+      if (keys_[i] != CodePacker::kNoKey) {
+        fn(keys_[i], counts_.empty() ? 0 : counts_[i],
+           firsts_.empty() ? 0 : firsts_[i]);
+      }
+    }
+  }
+
+private:
+  /// 槽数翻倍，重新放入全部键
+  void grow();
+
+  std::vector<std::uint64_t> keys_;
+  std::vector<std::uint64_t> counts_;
+  std::vector<std::uint64_t> firsts_;
+  bool countsEnabled_;
+  bool positionsEnabled_;
+  std::size_t size_ = 0;
+  unsigned shift_ = 0; ///< 槽下标为哈希值的高 64 - shift_ 位
+};
+
+/**
+ * @brief 汇总的输出格式
+ */
+enum class DedupFormat {
+  Csv,   ///< 每个编码一行：编码,规则[,次数][,首次位置]
+  Binary ///< 小端序的定长头和紧凑的记录，见 DedupSink::write
+};
+
+/**
+ * @brief 去重汇总参数
+ */
+struct DedupOptions {
+  DedupFormat format = DedupFormat::Csv;
+  bool counts = false;    ///< 统计每个编码的出现次数
+  bool positions = false; ///< 记录每个编码首次出现的位置
+
+  /**
+   * @brief 解析 --dedup= 的值，如 "csv"、"binary,count,first"
+   * @return 解析成功返回true
+   */
+  bool parse(std::string_view spec);
+};
+
+/**
+ * @brief 去重汇总：接收各线程报告的命中，结束时一次性输出
+ * add 可以在多个线程中同时调用
+ */
+class DedupSink {
+public:
+  /// 并行模式的分片数
+  static const std::size_t kShards = 64;
+
+  /**
+   * @param matchers 各规则的匹配器
+   * @param names 各规则的名称，与 matchers 一一对应
+   * @param options 汇总参数
+   * @param shards 分片数，单线程时为1
+   */
+  DedupSink(const std::vector<FixedMatcher> &matchers,
+            std::vector<std::string> names, const DedupOptions &options,
+            std::size_t shards);
+
+  /// 全部规则的编码都能装进64位键时返回true
+  bool valid() const { return packer_.valid(); }
+
+  /**
+   * @brief 报告一个命中
+   * @param rule 规则序号
+   * @param code 编码，长度为规则长度
+   * @param position 命中的位置（记录号或字节偏移）
+   */
+  void add(std::size_t rule, const char *code, std::uint64_t position);
+
+  /// 不同编码的个数
+  std::size_t size() const;
+
+  /**
+   * @brief 输出汇总
+   * 记录了首次位置时按首次位置排列，否则按 (规则, 编码) 排列。
+   * 二进制格式：8字节魔数 "STRREGD1"、4字节标志（位0为次数，位1为首次
+   * 位置）、8字节编码个数；每个编码依次为1字节规则序号、1字节长度、编码、
+   * 可选的8字节次数和8字节首次位置，整数均为小端序
+   */
+  void write(std::FILE *file) const;
+
+private:
+  struct alignas(64) Shard {
+    std::mutex mutex;
+    CodeSet set;
+    explicit Shard(const DedupOptions &options)
+        : set(options.counts, options.positions) {}
+  };
+
+  CodePacker packer_;
+  std::vector<std::string> names_;
+  DedupOptions options_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+} // namespace strreg
+
+#endif // STRREG_DEDUP_H
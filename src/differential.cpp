@@ -0,0 +1,495 @@
+/**
+ * @file differential.cpp
+ * @brief 差分校验的实现
+ */
+
+#include "differential.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "dedup.h"
+#include "extract.h"
+#include "fragments.h"
+#include "fuzzy.h"
+#include "reference.h"
+#include "stream.h"
+#include "strreg.h"
+#include "validator.h"
+
+namespace strreg {
+
+namespace {
+
+/// 与 rules/builtin.rules 相同的内置规则
+const char kBuiltinRules[] = "code11  YY[45679][012]....[12345][012].\n"
+                             "code8   YY[45679][012]....\n"
+                             "code10  YY[45679][012]....[A-G].\n";
+
+const Engine kEngines[] = {Engine::Regex, Engine::Table, Engine::Static,
+                           Engine::Automaton};
+
+/// 多年份接口只区分向量化扫描器和组合自动机两种查找方式
+const Engine kYearEngines[] = {Engine::Table, Engine::Automaton};
+
+const char *engineLabel(Engine engine) {
+  switch (engine) {
+  case Engine::Regex:
+    return "regex";
+  case Engine::Table:
+    return "table";
+  case Engine::Static:
+    return "static";
+  case Engine::Automaton:
+    return "automaton";
+  }
+  return "unknown";
+}
+
+/// 年份只含字母和数字时，原始实现的正则表达式才是按字面匹配年份
+bool literalYear(std::string_view year) {
+  for (char c : year) {
+    bool alnum = (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') ||
+                 (c >= 'a' && c <= 'z');
+    if (!alnum) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string boolText(bool value) { return value ? "true" : "false"; }
+
+std::string joinList(const std::vector<std::string> &items) {
+  std::string text = "[";
+  for (std::size_t i = 0; i < items.size(); ++i) {
+    text += i == 0 ? "" : ",";
+    text += DifferentialChecker::escape(items[i]);
+  }
+  return text + "]";
+}
+
+/// 把 findAll 的重叠结果化为从左到右不重叠的结果，与 sregex_iterator 一致
+std::vector<std::string> nonOverlapping(std::string_view input,
+                                        const std::vector<Match> &matches) {
+  std::vector<std::string> result;
+  std::size_t next = 0;
+  for (const Match &match : matches) {
+    if (match.offset >= next) {
+      result.emplace_back(match.view(input));
+      next = match.offset + match.length;
+    }
+  }
+  return result;
+}
+
+/// 把 findAll 的全部结果写成“偏移:规则”的列表
+std::string hitList(const std::vector<Match> &matches) {
+  std::string text = "[";
+  for (std::size_t i = 0; i < matches.size(); ++i) {
+    text += i == 0 ? "" : ",";
+    text += std::to_string(matches[i].offset) + ":" + ruleName(matches[i].rule);
+  }
+  return text + "]";
+}
+
+/// 按 code11、code8、code10 的顺序找出第一条整体匹配的规则
+std::string firstWholeRule(const std::string &input, const std::string &year) {
+  if (reference::validateString11(input, year)) {
+    return "code11";
+  }
+  if (reference::validateString8(input, year)) {
+    return "code8";
+  }
+  if (reference::validateString10(input, year)) {
+    return "code10";
+  }
+  return "-";
+}
+
+/**
+ * @brief 窗口改成符合规则所需的最少替换数，超过 maxErrors 时返回 npos
+ * 按替换数从少到多枚举替换的位置和混淆字符，不依赖近似扫描器的自动机
+ */
+std::size_t bruteForceCost(std::string window, RuleId rule,
+                           std::string_view year, const ConfusionTable &table,
+                           std::size_t maxErrors, std::size_t from = 0,
+                           std::size_t used = 0) {
+  if (getValidator(rule, year, Engine::Table).validate(window)) {
+    return used;
+  }
+  std::size_t best = std::string::npos;
+  if (used == maxErrors) {
+    return best;
+  }
+  for (std::size_t pos = from; pos < window.size(); ++pos) {
+    const char original = window[pos];
+    for (char sub : table.substitutes(static_cast<unsigned char>(original))) {
+      window[pos] = sub;
+      best = std::min(best, bruteForceCost(window, rule, year, table,
+                                           maxErrors, pos + 1, used + 1));
+    }
+    window[pos] = original;
+  }
+  return best;
+}
+
+} // namespace
+
+DifferentialChecker::DifferentialChecker() {
+  std::string error;
+  builtinRules_.parse(kBuiltinRules, error);
+}
+
+void DifferentialChecker::checkRecord(std::string_view input,
+                                      std::string_view year) {
+  if (!literalYear(year)) {
+    return;
+  }
+  const std::string text(input);
+  const std::string y(year);
+
+  const bool expect11 = reference::validateString11(text, y);
+  const bool expect8 = reference::validateString8(text, y);
+  const bool expect10 = reference::validateString10(text, y);
+  const std::string expectExtract = reference::extractValidString(text, y);
+  const std::vector<std::string> expectAll10 =
+      reference::extractValidStrings(text, y);
+
+  const Engine saved = defaultEngine();
+  std::vector<Match> matches;
+  for (Engine engine : kEngines) {
+    setDefaultEngine(engine);
+    const std::string suffix = std::string("/") + engineLabel(engine);
+
+    expect("validate11" + suffix, input, boolText(expect11),
+           boolText(validate(input, RuleId::Code11, year)));
+    expect("validate8" + suffix, input, boolText(expect8),
+           boolText(validate(input, RuleId::Code8, year)));
+    expect("validate10" + suffix, input, boolText(expect10),
+           boolText(validate(input, RuleId::Code10, year)));
+
+    Match extracted = extractValid(input, year);
+    expect("extractValid" + suffix, input, escape(expectExtract),
+           escape(extracted ? extracted.view(input) : "null"));
+
+    matches.clear();
+    findAll(input, {RuleId::Code10}, year, matches);
+    expect("findAll10" + suffix, input, joinList(expectAll10),
+           joinList(nonOverlapping(input, matches)));
+  }
+  setDefaultEngine(saved);
+
+  // 多年份接口和声明式规则；年份集合只接受两位数字年份
+  const YearSet years(year);
+  if (!years.empty()) {
+    const RuleId all[] = {RuleId::Code11, RuleId::Code8, RuleId::Code10};
+    std::string expectHits;
+    for (Engine engine : kYearEngines) {
+      setDefaultEngine(engine);
+      const std::string suffix = std::string("/years/") + engineLabel(engine);
+      expect("validate11" + suffix, input, boolText(expect11),
+             boolText(validate(input, RuleId::Code11, years).found()));
+      expect("validate10" + suffix, input, boolText(expect10),
+             boolText(validate(input, RuleId::Code10, years).found()));
+      Match extracted = extractValid(input, years);
+      expect("extractValid" + suffix, input, escape(expectExtract),
+             escape(extracted ? extracted.view(input) : "null"));
+
+      // 两种查找方式报告的全部匹配及其顺序必须完全相同
+      matches.clear();
+      findAll(input, all, 3, years, matches);
+      if (engine == Engine::Table) {
+        expectHits = hitList(matches);
+      } else {
+        expect("findAll" + suffix, input, expectHits, hitList(matches));
+      }
+
+      std::size_t rule = builtinRules_.validate(input, years);
+      expect("validate/rules" + suffix.substr(6), input,
+             firstWholeRule(text, y),
+             rule == RuleSet::npos ? "-" : builtinRules_.rule(rule).name);
+
+      // 批量接口逐条的结果与单条接口相同
+      const std::string_view record = input;
+      Match batch;
+      extractBatch(&record, 1, {RuleId::Code11, RuleId::Code8}, years, &batch);
+      expect("extractBatch" + suffix.substr(6), input, escape(expectExtract),
+             escape(batch ? batch.view(input) : "null"));
+      validateBatch(&record, 1, all, 3, years, &batch);
+      expect("validateBatch" + suffix.substr(6), input,
+             firstWholeRule(text, y), batch ? ruleName(batch.rule) : "-");
+    }
+    setDefaultEngine(saved);
+
+    // 不允许替换时，近似扫描器的结果与精确接口相同
+    const RuleId daduanmian[] = {RuleId::Code11, RuleId::Code8};
+    const FuzzyScanner extractor(daduanmian, 2, years, ConfusionTable::ocr(),
+                                 0);
+    FuzzyMatch fuzzy = extractor.extract(input);
+    expect("extract/fuzzy", input, escape(expectExtract),
+           escape(fuzzy ? fuzzy.correction() : "null"));
+    const FuzzyScanner validator(all, 3, years, ConfusionTable::ocr(), 0);
+    fuzzy = validator.validate(input);
+    expect("validate/fuzzy", input, firstWholeRule(text, y),
+           fuzzy ? ruleName(fuzzy.match.rule) : "-");
+
+    // 去重汇总的键还原后与原编码相同
+    const Match extracted = extractValid(input, years);
+    if (extracted) {
+      const CodePacker packer({FixedMatcher::compile(RuleId::Code11, years),
+                               FixedMatcher::compile(RuleId::Code8, years)});
+      const std::size_t rule = extracted.rule == RuleId::Code11 ? 0 : 1;
+      char code[FixedMatcher::kMaxLength];
+      std::size_t unpacked;
+      std::size_t length = packer.unpack(
+          packer.pack(rule, input.data() + extracted.offset), code, unpacked);
+      expect("dedup/key", input, escape(extracted.view(input)),
+             escape(unpacked == rule ? std::string_view(code, length)
+                                     : std::string_view()));
+    }
+
+    // 按块输入流式匹配器，按偏移和规则排序后与一次 findAll 相同
+    StreamMatcher stream(all, 3, years);
+    for (std::size_t step : {1, 3, 7}) {
+      matches.clear();
+      for (std::size_t begin = 0; begin < input.length(); begin += step) {
+        stream.feed(input.substr(begin, step), matches);
+      }
+      stream.finish();
+      std::sort(matches.begin(), matches.end(),
+                [](const Match &a, const Match &b) {
+                  return a.offset != b.offset ? a.offset < b.offset
+                                              : a.rule < b.rule;
+                });
+      expect("findAll/stream:" + std::to_string(step), input, expectHits,
+             hitList(matches));
+    }
+  }
+}
+
+void DifferentialChecker::checkFragments(
+    const std::vector<std::string> &fragments, std::string_view year) {
+  if (!literalYear(year) || fragments.size() > kMaxReferenceFragments) {
+    return;
+  }
+  const std::string y(year);
+  std::string label;
+  for (const std::string &fragment : fragments) {
+    label += label.empty() ? "" : " | ";
+    label += fragment;
+  }
+
+  std::vector<std::string_view> views(fragments.begin(), fragments.end());
+  Code code = findInFragments(views, year);
+  expect("findInFragments", label,
+         escape(reference::findValidFromFragments(fragments, y)),
+         escape(code ? code.view() : "null"));
+  const std::vector<std::string> all =
+      reference::extractFromFragments(fragments, y);
+  expect("extractFromFragments", label, joinList(all),
+         joinList(extractFromFragments(views, year)));
+
+  // 缓存：第一次调用未命中，第二次命中，两次结果都必须与原始实现一致
+  for (int round = 0; round < 2; ++round) {
+    std::string suffix = round == 0 ? "/cache-miss" : "/cache-hit";
+    Code cached = cache_.find(views, year);
+    expect("findInFragments" + suffix, label,
+           escape(reference::findValidFromFragments(fragments, y)),
+           escape(cached ? cached.view() : "null"));
+    expect("extractFromFragments" + suffix, label, joinList(all),
+           joinList(cache_.extract(views, year)));
+  }
+
+  // 限定个数时返回完整结果中的前若干个不同编码
+  for (std::size_t limit = 1; limit <= 2; ++limit) {
+    std::vector<std::string> first = extractFromFragments(views, year, limit);
+    bool subset = std::includes(all.begin(), all.end(), first.begin(),
+                                first.end());
+    expect("extractFromFragments/first:" + std::to_string(limit), label,
+           std::to_string(std::min(limit, all.size())) + " subset",
+           std::to_string(first.size()) + (subset ? " subset" : " extra"));
+  }
+}
+
+void DifferentialChecker::checkParallelFragments(
+    const std::vector<std::string> &fragments, std::string_view year) {
+  if (fragments.size() > kMaxFragments) {
+    return;
+  }
+  std::string label;
+  for (const std::string &fragment : fragments) {
+    label += label.empty() ? "" : " | ";
+    label += fragment;
+  }
+
+  if (!pool_) {
+    pool_ = std::make_unique<WorkStealingPool>(kParallelThreads);
+  }
+  WorkStealingPool &pool = *pool_;
+
+  std::vector<std::string_view> views(fragments.begin(), fragments.end());
+  Code code = findInFragments(views, year);
+  Code parallel = findInFragments(views, year, pool);
+  expect("findInFragments/parallel", label, escape(code ? code.view() : "null"),
+         escape(parallel ? parallel.view() : "null"));
+  const std::vector<std::string> all = extractFromFragments(views, year);
+  expect("extractFromFragments/parallel", label, joinList(all),
+         joinList(extractFromFragments(views, year, pool)));
+
+  // 限定个数时是按搜索顺序最先找到的编码，与顺序版本完全相同
+  for (std::size_t limit = 1; limit <= 2; ++limit) {
+    expect("extractFromFragments/parallel/first:" + std::to_string(limit),
+           label, joinList(extractFromFragments(views, year, limit)),
+           joinList(extractFromFragments(views, year, pool, limit)));
+  }
+}
+
+void DifferentialChecker::checkFuzzy(std::string_view input,
+                                     std::string_view year,
+                                     std::size_t maxErrors) {
+  const YearSet years(year);
+  if (years.empty()) {
+    return;
+  }
+  const RuleId all[] = {RuleId::Code11, RuleId::Code8, RuleId::Code10};
+  const ConfusionTable table = ConfusionTable::ocr();
+  const FuzzyScanner scanner(all, 3, years, table, maxErrors);
+  const std::string k = "/k:" + std::to_string(scanner.maxErrors());
+
+  std::string expected = "[";
+  for (std::size_t offset = 0; offset < input.length(); ++offset) {
+    for (RuleId rule : all) {
+      const std::size_t length = ruleLength(rule);
+      if (offset + length > input.length()) {
+        continue;
+      }
+      std::size_t cost =
+          bruteForceCost(std::string(input.substr(offset, length)), rule,
+                         year, table, scanner.maxErrors());
+      if (cost != std::string::npos) {
+        expected += expected.size() == 1 ? "" : ",";
+        expected += std::to_string(offset) + ":" + ruleName(rule) + ":" +
+                    std::to_string(cost);
+      }
+    }
+  }
+  expected += "]";
+
+  std::vector<FuzzyMatch> matches;
+  scanner.findAll(input, matches);
+  std::string actual = "[";
+  for (const FuzzyMatch &m : matches) {
+    actual += actual.size() == 1 ? "" : ",";
+    actual += std::to_string(m.match.offset) + ":" + ruleName(m.match.rule) +
+              ":" + std::to_string(m.cost);
+
+    // 改正后的编码符合规则，且恰好改了 cost 个字符
+    const std::string_view window =
+        input.substr(m.match.offset, m.match.length);
+    std::size_t changed = 0;
+    for (std::size_t i = 0; i < window.length(); ++i) {
+      changed += window[i] != m.corrected[i];
+    }
+    expect("findAll/fuzzy/correction" + k, input, "valid:" +
+           std::to_string(m.cost),
+           std::string(getValidator(m.match.rule, year, Engine::Table)
+                                   .validate(m.correction())
+                               ? "valid:"
+                               : "invalid:") +
+               std::to_string(changed));
+  }
+  actual += "]";
+  expect("findAll/fuzzy" + k, input, expected, actual);
+}
+
+void DifferentialChecker::checkFragmentCache(
+    const std::vector<std::vector<std::string>> &sets, std::string_view year) {
+  if (sets.size() < 2) {
+    return;
+  }
+  std::string label;
+  for (const std::vector<std::string> &set : sets) {
+    for (const std::string &fragment : set) {
+      label += label.empty() ? "" : " | ";
+      label += fragment;
+    }
+    label += " ||";
+  }
+  std::vector<std::vector<std::string_view>> views;
+  std::vector<std::string> expected;
+  for (const std::vector<std::string> &set : sets) {
+    views.emplace_back(set.begin(), set.end());
+    Code code = findInFragments(views.back(), year);
+    expected.push_back(escape(code ? code.view() : "null"));
+  }
+
+  // 容量比组数少一：按同一顺序查询两轮，每次都淘汰最久未用的一组，
+  // 第二轮全部未命中并重新计算
+  FragmentCache::Options options;
+  options.capacity = sets.size() - 1;
+  options.shards = 1;
+  FragmentCache bounded(options);
+  for (std::size_t round = 0; round < 2; ++round) {
+    for (std::size_t i = 0; i < views.size(); ++i) {
+      Code code = bounded.find(views[i], year);
+      expect("cache/evict/find", label, expected[i],
+             escape(code ? code.view() : "null"));
+    }
+  }
+  FragmentCache::Stats stats = bounded.stats();
+  const std::size_t n = sets.size();
+  expect("cache/evict/stats", label,
+         std::to_string(2 * n) + " misses " + std::to_string(n + 1) +
+             " evictions " + std::to_string(n - 1) + " entries",
+         std::to_string(stats.misses) + " misses " +
+             std::to_string(stats.evictions) + " evictions " +
+             std::to_string(stats.size) + " entries");
+
+  // 过期：条目超过存活时间后不再命中，重新计算的结果不变
+  options.capacity = n;
+  options.ttl = std::chrono::milliseconds(1);
+  FragmentCache expiring(options);
+  expiring.find(views[0], year);
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  Code code = expiring.find(views[0], year);
+  expect("cache/expire/find", label, expected[0],
+         escape(code ? code.view() : "null"));
+  stats = expiring.stats();
+  expect("cache/expire/stats", label, "1 expirations 0 hits",
+         std::to_string(stats.expirations) + " expirations " +
+             std::to_string(stats.hits) + " hits");
+}
+
+std::string DifferentialChecker::escape(std::string_view text) {
+  std::string out;
+  for (char c : text) {
+    unsigned char byte = static_cast<unsigned char>(c);
+    if (byte >= 0x20 && byte < 0x7f && byte != '\\') {
+      out.push_back(c);
+    } else {
+      char hex[8];
+      std::snprintf(hex, sizeof(hex), "\\x%02x", byte);
+      out += hex;
+    }
+  }
+  return out;
+}
+
+void DifferentialChecker::expect(const std::string &check,
+                                 std::string_view input,
+                                 const std::string &expected,
+                                 const std::string &actual) {
+  ++checks_;
+  if (expected == actual) {
+    return;
+  }
+  ++failures_;
+  if (mismatches_.size() < kMaxReported) {
+    mismatches_.push_back(Mismatch{check, escape(input), expected, actual});
+  }
+}
+
+} // namespace strreg
@@ -0,0 +1,119 @@
+/**
+ * @file differential.h
+ * @brief 快速引擎与原始正则实现之间的差分校验
+ *
+ * 对同一个输入分别调用 reference.h 中的原始实现和各个快速引擎
+ * （Regex、Table、Static 引擎，多年份接口，声明式规则），记录所有不一致。
+ * strreg_verify 和模糊测试入口共用这里的检查。
+ */
+
+#ifndef STRREG_DIFFERENTIAL_H
+#define STRREG_DIFFERENTIAL_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "fragment_cache.h"
+#include "rule_spec.h"
+#include "work_stealing.h"
+
+namespace strreg {
+
+/**
+ * @brief 一次不一致
+ */
+struct Mismatch {
+  std::string check;    ///< 检查项名称，含引擎
+  std::string input;    ///< 转义后的输入
+  std::string expected; ///< 原始实现的结果
+  std::string actual;   ///< 快速引擎的结果
+};
+
+/**
+ * @brief 差分校验器
+ */
+class DifferentialChecker {
+public:
+  /// 原始片段搜索枚举全部排列，片段数超过该值时不做片段检查
+  static const std::size_t kMaxReferenceFragments = 6;
+  /// 并行检查使用的线程数，与硬件线程数无关，保证总是走并行路径
+  static constexpr std::size_t kParallelThreads = 4;
+  /// 最多保留的不一致详情数
+  static const std::size_t kMaxReported = 100;
+
+  DifferentialChecker();
+
+  /**
+   * @brief 检查一条输入的整串验证、提取和10位搜索
+   * 年份含有正则表达式元字符时原始实现会把它当作模式，这类年份被跳过
+   *
+   * @param input 输入，可以含有任意字节
+   * @param year 年份
+   */
+  void checkRecord(std::string_view input, std::string_view year);
+
+  /**
+   * @brief 检查片段搜索（11位/8位的排列搜索和10位的子集搜索）
+   * @param fragments 片段
+   * @param year 年份
+   */
+  void checkFragments(const std::vector<std::string> &fragments,
+                      std::string_view year);
+
+  /**
+   * @brief 检查片段搜索的并行版本：结果与顺序版本相同
+   * 片段较多时原始实现无法枚举全部排列，以顺序版本为准
+   *
+   * @param fragments 片段，通常不少于 kParallelFragments 个
+   * @param year 年份
+   */
+  void checkParallelFragments(const std::vector<std::string> &fragments,
+                              std::string_view year);
+
+  /**
+   * @brief 检查 k 个替换以内的近似查找
+   * 以逐窗口枚举按混淆表替换的全部改法、再用查表引擎验证的结果为准
+   *
+   * @param input 输入
+   * @param year 两位年份
+   * @param maxErrors 允许的最多替换数
+   */
+  void checkFuzzy(std::string_view input, std::string_view year,
+                  std::size_t maxErrors);
+
+  /**
+   * @brief 检查片段缓存的容量淘汰和过期：结果不变，计数符合预期
+   * @param sets 互不相同的若干组片段，至少两组
+   * @param year 年份
+   */
+  void checkFragmentCache(const std::vector<std::vector<std::string>> &sets,
+                          std::string_view year);
+
+  /// 已做的比较次数
+  std::size_t checks() const { return checks_; }
+  /// 不一致的次数
+  std::size_t failures() const { return failures_; }
+  /// 前 kMaxReported 个不一致的详情
+  const std::vector<Mismatch> &mismatches() const { return mismatches_; }
+
+  /// 把任意字节转义成可打印的形式，用于报告
+  static std::string escape(std::string_view text);
+
+private:
+  void expect(const std::string &check, std::string_view input,
+              const std::string &expected, const std::string &actual);
+
+  RuleSet builtinRules_;
+  FragmentCache cache_;
+  std::unique_ptr<WorkStealingPool> pool_; ///< 第一次并行检查时创建
+  std::size_t checks_ = 0;
+  std::size_t failures_ = 0;
+  std::vector<Mismatch> mismatches_;
+};
+
+} // namespace strreg
+
+#endif // STRREG_DIFFERENTIAL_H
@@ -0,0 +1,260 @@
+/**
+ * @file extract.cpp
+ * @brief 基于 std::string_view 的验证与提取接口的实现
+ */
+
+#include "extract.h"
+
+#include "automaton.h"
+#include "metrics.h"
+#include "static_rules.h"
+#include "window_scanner.h"
+
+namespace strreg {
+
+namespace {
+
+Match makeMatch(std::size_t offset, RuleId rule, std::size_t year = 0) {
+  Match match;
+  match.offset = offset;
+  match.length = ruleLength(rule);
+  match.rule = rule;
+  match.year = year;
+  return match;
+}
+
+/// 统计返回给调用者的匹配
+Match counted(Match match) {
+  if (match) {
+    STRREG_COUNT_AT(metrics::matchCounter(match.rule), 1);
+  }
+  return match;
+}
+
+/// 统计一次 extractValid 的结果，8位匹配说明没有找到11位匹配
+Match countedExtract(Match match) {
+  STRREG_COUNT(ExtractCalls, 1);
+  if (match && match.rule == RuleId::Code8) {
+    STRREG_COUNT(ExtractFallback, 1);
+  }
+  return counted(match);
+}
+
+/**
+ * @brief 用正则引擎逐个窗口查找第一个匹配
+ */
+Match firstWindow(std::string_view input, const Validator &validator) {
+  const std::size_t len = validator.length();
+  const std::string_view year = validator.year();
+  for (std::size_t i = 0; i + len <= input.length(); ++i) {
+    // 先比较年份，避免对明显不符合的窗口运行正则表达式
+    if (input.compare(i, year.length(), year) != 0) {
+      continue;
+    }
+    STRREG_COUNT(YearCandidates, 1);
+    STRREG_COUNT(RuleChecks, 1);
+    if (validator.validate(input.substr(i, len))) {
+      return makeMatch(i, validator.rule());
+    }
+  }
+  return Match();
+}
+
+} // namespace
+
+bool validate(std::string_view str, RuleId rule, std::string_view year) {
+  STRREG_TIME(Validate);
+  if (year.length() != 2) {
+    return false;
+  }
+  STRREG_COUNT(RuleChecks, 1);
+  // 编译期规则无需查验证器缓存
+  bool valid = defaultEngine() == Engine::Static
+                   ? staticValidate(str, rule, year)
+                   : getValidator(rule, year).validate(str);
+  if (valid) {
+    STRREG_COUNT_AT(metrics::matchCounter(rule), 1);
+  }
+  return valid;
+}
+
+Match extractValid(std::string_view input, std::string_view year) {
+  STRREG_TIME(Extract);
+  if (year.length() != 2) {
+    return Match();
+  }
+  STRREG_COUNT(BytesScanned, input.length());
+
+  // 查表引擎：一趟扫描同时找出11位和8位匹配
+  if (defaultEngine() != Engine::Regex) {
+    const WindowScanner &scanner =
+        getWindowScanner({RuleId::Code11, RuleId::Code8}, year);
+    Match first11;
+    Match first8;
+    scanWindows(scanner, input.data(), input.length(),
+                [&](std::size_t rule, std::size_t offset) {
+                  if (rule == 0) {
+                    first11 = makeMatch(offset, RuleId::Code11);
+                    return false;
+                  }
+                  if (!first8) {
+                    first8 = makeMatch(offset, RuleId::Code8);
+                  }
+                  return true;
+                });
+    return countedExtract(first11 ? first11 : first8);
+  }
+
+  // 正则引擎：先找11位匹配，没有时再找8位匹配
+  Match match = firstWindow(input, getValidator(RuleId::Code11, year));
+  if (!match) {
+    match = firstWindow(input, getValidator(RuleId::Code8, year));
+  }
+  return countedExtract(match);
+}
+
+Match findFirst(std::string_view input, RuleId rule, std::string_view year) {
+  STRREG_TIME(Find);
+  if (year.length() != 2) {
+    return Match();
+  }
+  STRREG_COUNT(BytesScanned, input.length());
+  if (defaultEngine() != Engine::Regex) {
+    Match first;
+    scanWindows(getWindowScanner({rule}, year), input.data(), input.length(),
+                [&](std::size_t, std::size_t offset) {
+                  first = makeMatch(offset, rule);
+                  return false;
+                });
+    return counted(first);
+  }
+  return counted(firstWindow(input, getValidator(rule, year)));
+}
+
+std::size_t findAll(std::string_view input, const RuleId *rules,
+                    std::size_t count, std::string_view year,
+                    std::vector<Match> &out) {
+  STRREG_TIME(Find);
+  if (year.length() != 2) {
+    return 0;
+  }
+  STRREG_COUNT(BytesScanned, input.length());
+  const std::size_t before = out.size();
+
+  if (defaultEngine() != Engine::Regex) {
+    scanWindows(getWindowScanner(rules, count, year), input.data(),
+                input.length(), [&](std::size_t rule, std::size_t offset) {
+                  out.push_back(counted(makeMatch(offset, rules[rule])));
+                  return true;
+                });
+    return out.size() - before;
+  }
+
+  // 正则引擎：同样只走一遍偏移，每个偏移依次尝试各条规则
+  for (std::size_t i = 0; i + 2 <= input.length(); ++i) {
+    if (input.compare(i, 2, year) != 0) {
+      continue;
+    }
+    STRREG_COUNT(YearCandidates, 1);
+    for (std::size_t r = 0; r < count; ++r) {
+      const Validator &validator = getValidator(rules[r], year);
+      if (i + validator.length() > input.length()) {
+        continue;
+      }
+      STRREG_COUNT(RuleChecks, 1);
+      if (validator.validate(input.substr(i, validator.length()))) {
+        out.push_back(counted(makeMatch(i, rules[r])));
+      }
+    }
+  }
+  return out.size() - before;
+}
+
+Match validate(std::string_view str, RuleId rule, const YearSet &years) {
+  STRREG_TIME(Validate);
+  if (years.empty() || str.length() != ruleLength(rule)) {
+    return Match();
+  }
+  std::size_t year = years.indexOf(str.data());
+  if (year == YearSet::npos) {
+    return Match();
+  }
+  STRREG_COUNT(YearCandidates, 1);
+  STRREG_COUNT(RuleChecks, 1);
+  if (!getWindowScanner({rule}, years).matcher(0).matchAt(str.data())) {
+    return Match();
+  }
+  return counted(makeMatch(0, rule, year));
+}
+
+Match extractValid(std::string_view input, const YearSet &years) {
+  STRREG_TIME(Extract);
+  if (years.empty()) {
+    return Match();
+  }
+  STRREG_COUNT(BytesScanned, input.length());
+  const WindowScanner &scanner =
+      getWindowScanner({RuleId::Code11, RuleId::Code8}, years);
+  Match first11;
+  Match first8;
+  scanWindows(scanner, input.data(), input.length(),
+              [&](std::size_t rule, std::size_t offset) {
+                std::size_t year = years.indexOf(input.data() + offset);
+                if (year == YearSet::npos) {
+                  return true;
+                }
+                STRREG_COUNT(YearCandidates, 1);
+                if (rule == 0) {
+                  first11 = makeMatch(offset, RuleId::Code11, year);
+                  return false;
+                }
+                if (!first8) {
+                  first8 = makeMatch(offset, RuleId::Code8, year);
+                }
+                return true;
+              });
+  return countedExtract(first11 ? first11 : first8);
+}
+
+Match findFirst(std::string_view input, RuleId rule, const YearSet &years) {
+  STRREG_TIME(Find);
+  if (years.empty()) {
+    return Match();
+  }
+  STRREG_COUNT(BytesScanned, input.length());
+  Match first;
+  scanWindows(getWindowScanner({rule}, years), input.data(), input.length(),
+              [&](std::size_t, std::size_t offset) {
+                std::size_t year = years.indexOf(input.data() + offset);
+                if (year == YearSet::npos) {
+                  return true;
+                }
+                STRREG_COUNT(YearCandidates, 1);
+                first = makeMatch(offset, rule, year);
+                return false;
+              });
+  return counted(first);
+}
+
+std::size_t findAll(std::string_view input, const RuleId *rules,
+                    std::size_t count, const YearSet &years,
+                    std::vector<Match> &out) {
+  STRREG_TIME(Find);
+  if (years.empty()) {
+    return 0;
+  }
+  STRREG_COUNT(BytesScanned, input.length());
+  const std::size_t before = out.size();
+  scanWindows(getWindowScanner(rules, count, years), input.data(),
+              input.length(), [&](std::size_t rule, std::size_t offset) {
+                std::size_t year = years.indexOf(input.data() + offset);
+                if (year != YearSet::npos) {
+                  STRREG_COUNT(YearCandidates, 1);
+                  out.push_back(counted(makeMatch(offset, rules[rule], year)));
+                }
+                return true;
+              });
+  return out.size() - before;
+}
+
+} // namespace strreg
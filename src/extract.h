@@ -0,0 +1,168 @@
+/**
+ * @file extract.h
+ * @brief 基于 std::string_view 的零分配验证与提取接口
+ *
+ * 这些函数直接在调用方的缓冲区（包括 mmap 映射的文件或网络缓冲区）上工作，
+ * 返回偏移或视图而不是新建的 std::string，并用显式的“未找到”值代替 "null"。
+ * 使用查表引擎时热路径上不分配内存。
+ */
+
+#ifndef STRREG_EXTRACT_H
+#define STRREG_EXTRACT_H
+
+#include <cstddef>
+#include <initializer_list>
+#include <string_view>
+#include <vector>
+
+#include "validator.h"
+#include "years.h"
+
+namespace strreg {
+
+/**
+ * @brief 输入缓冲区中的一个匹配
+ */
+struct Match {
+  /// 表示未找到的偏移
+  static constexpr std::size_t npos = std::string_view::npos;
+
+  std::size_t offset = npos;    ///< 匹配在输入中的起始偏移
+  std::size_t length = 0;       ///< 匹配长度
+  RuleId rule = RuleId::Code11; ///< 匹配的规则
+  std::size_t year = 0; ///< 命中的年份在 YearSet 中的下标，单年份接口恒为0
+
+  bool found() const { return offset != npos; }
+  explicit operator bool() const { return found(); }
+
+  /**
+   * @brief 返回匹配在输入中的视图
+   * @param input 产生该匹配的输入
+   * @return 指向 input 内部的视图；未找到时为空视图
+   */
+  std::string_view view(std::string_view input) const {
+    return found() ? input.substr(offset, length) : std::string_view();
+  }
+};
+
+/**
+ * @brief 由片段拼接得到的编码，内联存储，不分配内存
+ */
+struct Code {
+  /// 可容纳的最大编码长度
+  static constexpr std::size_t kCapacity = 16;
+
+  char data[kCapacity] = {};
+  std::size_t length = 0;       ///< 编码长度，0表示未找到
+  RuleId rule = RuleId::Code11; ///< 匹配的规则
+
+  bool found() const { return length != 0; }
+  explicit operator bool() const { return found(); }
+  std::string_view view() const { return std::string_view(data, length); }
+};
+
+/**
+ * @brief 验证整个字符串是否符合规则
+ * @param str 需要验证的字符串
+ * @param rule 规则
+ * @param year 两位年份
+ * @return 符合规则返回true；年份不是两位时返回false
+ */
+bool validate(std::string_view str, RuleId rule, std::string_view year);
+
+/**
+ * @brief 从输入中提取符合规则的11位或8位子串
+ * 优先返回第一个11位匹配，没有时返回第一个8位匹配
+ *
+ * @param input 输入
+ * @param year 两位年份
+ * @return 匹配在输入中的位置；没有匹配或年份不是两位时 found() 为false
+ */
+Match extractValid(std::string_view input, std::string_view year);
+
+/**
+ * @brief 查找输入中第一个符合指定规则的子串
+ * @param input 输入
+ * @param rule 规则
+ * @param year 两位年份
+ * @return 匹配在输入中的位置；没有匹配或年份不是两位时 found() 为false
+ */
+Match findFirst(std::string_view input, RuleId rule, std::string_view year);
+
+/**
+ * @brief 一趟扫描找出输入中所有符合任一规则的子串，包括互相重叠的子串
+ * 结果按偏移从小到大排列，同一偏移按 rules 中的顺序排列
+ *
+ * @param input 输入
+ * @param rules 规则数组
+ * @param count 规则个数
+ * @param year 两位年份
+ * @param out 结果追加到这里；调用方复用同一个 vector 时热路径上不分配内存
+ * @return 找到的匹配个数；年份不是两位时为0
+ */
+std::size_t findAll(std::string_view input, const RuleId *rules,
+                    std::size_t count, std::string_view year,
+                    std::vector<Match> &out);
+
+inline std::size_t findAll(std::string_view input,
+                           std::initializer_list<RuleId> rules,
+                           std::string_view year, std::vector<Match> &out) {
+  return findAll(input, rules.begin(), rules.size(), year, out);
+}
+
+/*
+ * 多年份接口：一趟扫描同时接受集合中的全部年份，年份由查找表判断，
+ * 代价与年份个数无关。这些接口总是使用查表扫描器，结果与逐个年份调用
+ * 单年份接口后合并（取偏移最小者）一致，Match::year 给出命中的年份。
+ */
+
+/**
+ * @brief 验证整个字符串是否符合规则且年份在集合中
+ * @param str 需要验证的字符串
+ * @param rule 规则
+ * @param years 年份集合
+ * @return 匹配时 offset 为0、year 为命中的年份；不符合时 found() 为false
+ */
+Match validate(std::string_view str, RuleId rule, const YearSet &years);
+
+/**
+ * @brief 从输入中提取符合规则、年份在集合中的11位或8位子串
+ * 优先返回第一个11位匹配，没有时返回第一个8位匹配
+ *
+ * @param input 输入
+ * @param years 年份集合
+ * @return 匹配在输入中的位置及命中的年份
+ */
+Match extractValid(std::string_view input, const YearSet &years);
+
+/**
+ * @brief 查找输入中第一个符合规则、年份在集合中的子串
+ * @param input 输入
+ * @param rule 规则
+ * @param years 年份集合
+ * @return 匹配在输入中的位置及命中的年份
+ */
+Match findFirst(std::string_view input, RuleId rule, const YearSet &years);
+
+/**
+ * @brief 一趟扫描找出所有符合任一规则、年份在集合中的子串
+ * @param input 输入
+ * @param rules 规则数组
+ * @param count 规则个数
+ * @param years 年份集合
+ * @param out 结果追加到这里，Match::year 为命中的年份
+ * @return 找到的匹配个数
+ */
+std::size_t findAll(std::string_view input, const RuleId *rules,
+                    std::size_t count, const YearSet &years,
+                    std::vector<Match> &out);
+
+inline std::size_t findAll(std::string_view input,
+                           std::initializer_list<RuleId> rules,
+                           const YearSet &years, std::vector<Match> &out) {
+  return findAll(input, rules.begin(), rules.size(), years, out);
+}
+
+} // namespace strreg
+
+#endif // STRREG_EXTRACT_H
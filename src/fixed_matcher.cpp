@@ -0,0 +1,92 @@
+/**
+ * @file fixed_matcher.cpp
+ * @brief 定长逐位查表匹配器的实现
+ */
+
+#include "fixed_matcher.h"
+
+#include <cstring>
+
+#include "validator.h"
+#include "years.h"
+
+namespace strreg {
+
+FixedMatcher::FixedMatcher(std::size_t length)
+    : length_(length < kMaxLength ? length : kMaxLength) {
+  std::memset(table_, 0, sizeof(table_));
+}
+
+FixedMatcher FixedMatcher::compile(RuleId rule, std::string_view year) {
+  FixedMatcher matcher(ruleLength(rule));
+
+  // 前两位是年份
+  for (std::size_t i = 0; i < 2 && i < year.length(); ++i) {
+    matcher.allowChar(i, static_cast<unsigned char>(year[i]));
+  }
+  // 第3位只能是4、5、6、7、9，第4位只能是0、1、2
+  matcher.allowChars(2, "45679");
+  matcher.allowChars(3, "012");
+  // 第5-8位可以是任意字符
+  for (std::size_t i = 4; i < 8; ++i) {
+    matcher.allowAny(i);
+  }
+
+  switch (rule) {
+  case RuleId::Code11:
+    // 第9位只能是1-5，第10位只能是0、1、2，第11位任意
+    matcher.allowChars(8, "12345");
+    matcher.allowChars(9, "012");
+    matcher.allowAny(10);
+    break;
+  case RuleId::Code10:
+    // 第9位只能是A-G，第10位任意
+    matcher.allowRange(8, 'A', 'G');
+    matcher.allowAny(9);
+    break;
+  case RuleId::Code8:
+    break;
+  }
+  return matcher;
+}
+
+FixedMatcher FixedMatcher::compile(RuleId rule, const YearSet &years) {
+  // 年份两位先留空，再逐个加入集合中的年份
+  FixedMatcher matcher = compile(rule, std::string_view());
+  for (std::size_t i = 0; i < years.size(); ++i) {
+    std::string_view year = years.year(i);
+    matcher.allowChar(0, static_cast<unsigned char>(year[0]));
+    matcher.allowChar(1, static_cast<unsigned char>(year[1]));
+  }
+  return matcher;
+}
+
+void FixedMatcher::allowChar(std::size_t pos, unsigned char c) {
+  if (pos < length_) {
+    table_[pos][c] = 1;
+  }
+}
+
+void FixedMatcher::allowChars(std::size_t pos, std::string_view chars) {
+  for (char c : chars) {
+    allowChar(pos, static_cast<unsigned char>(c));
+  }
+}
+
+void FixedMatcher::allowRange(std::size_t pos, unsigned char lo,
+                              unsigned char hi) {
+  for (unsigned c = lo; c <= hi; ++c) {
+    allowChar(pos, static_cast<unsigned char>(c));
+  }
+}
+
+void FixedMatcher::allowAny(std::size_t pos) {
+  allowRange(pos, 0, 255);
+  // ECMAScript 正则表达式中的 . 不匹配行结束符
+  if (pos < length_) {
+    table_[pos][static_cast<unsigned char>('\n')] = 0;
+    table_[pos][static_cast<unsigned char>('\r')] = 0;
+  }
+}
+
+} // namespace strreg
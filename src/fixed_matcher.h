@@ -0,0 +1,103 @@
+/**
+ * @file fixed_matcher.h
+ * @brief 不依赖正则引擎的定长逐位查表匹配器
+ *
+ * 所有内置规则都是定长的逐位字符类检查，因此可以把规则编译成
+ * “每一位一张256项查找表”，验证时每一位只需一次查表和一次按位与。
+ */
+
+#ifndef STRREG_FIXED_MATCHER_H
+#define STRREG_FIXED_MATCHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace strreg {
+
+enum class RuleId;
+class YearSet;
+
+/**
+ * @brief 逐位查表匹配器
+ * 第 pos 位允许的字节 c 满足 table_[pos][c] == 1
+ */
+class FixedMatcher {
+public:
+  /// 支持的最大规则长度
+  static const std::size_t kMaxLength = 16;
+
+  /**
+   * @brief 构造长度为 length 的匹配器，初始时每一位都不允许任何字节
+   * @param length 规则长度，不超过 kMaxLength
+   */
+  explicit FixedMatcher(std::size_t length = 0);
+
+  /**
+   * @brief 按内置规则和年份编译匹配器
+   * 年份按字面字符匹配，结果与正则表达式版本一致
+   *
+   * @param rule 规则
+   * @param year 两位年份
+   * @return 编译好的匹配器
+   */
+  static FixedMatcher compile(RuleId rule, std::string_view year);
+
+  /**
+   * @brief 按内置规则编译接受多个年份的匹配器
+   * 前两位分别允许各年份在该位上的字符，因此可能接受年份的交叉组合
+   * （如 22 与 35 同时接受 25），命中后还需用 YearSet::indexOf 确认年份
+   *
+   * @param rule 规则
+   * @param years 年份集合
+   * @return 编译好的匹配器
+   */
+  static FixedMatcher compile(RuleId rule, const YearSet &years);
+
+  /// 第 pos 位允许字节 c
+  void allowChar(std::size_t pos, unsigned char c);
+  /// 第 pos 位允许 chars 中的每一个字节
+  void allowChars(std::size_t pos, std::string_view chars);
+  /// 第 pos 位允许 [lo, hi] 范围内的字节
+  void allowRange(std::size_t pos, unsigned char lo, unsigned char hi);
+  /// 第 pos 位允许任意字节（与正则表达式的 . 相同，不包括 \n 和 \r）
+  void allowAny(std::size_t pos);
+
+  /**
+   * @brief 验证长度为 len 的字符串是否整体符合规则
+   * @param str 字符串起始地址
+   * @param len 字符串长度
+   * @return 符合规则返回true，否则返回false
+   */
+  bool match(const char *str, std::size_t len) const {
+    return len == length_ && matchAt(str);
+  }
+
+  /**
+   * @brief 验证从 str 开始的 length() 个字节是否符合规则
+   * 调用方需保证至少有 length() 个字节可读
+   */
+  bool matchAt(const char *str) const {
+    unsigned ok = 1;
+    for (std::size_t i = 0; i < length_; ++i) {
+      ok &= table_[i][static_cast<unsigned char>(str[i])];
+    }
+    return ok != 0;
+  }
+
+  /// 第 pos 位是否允许字节 c
+  bool allows(std::size_t pos, unsigned char c) const {
+    return table_[pos][c] != 0;
+  }
+
+  std::size_t length() const { return length_; }
+
+private:
+  std::size_t length_;
+  std::uint8_t table_[kMaxLength][256];
+};
+
+} // namespace strreg
+
+#endif // STRREG_FIXED_MATCHER_H
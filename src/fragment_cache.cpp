@@ -0,0 +1,206 @@
+/**
+ * @file fragment_cache.cpp
+ * @brief 片段查询缓存的实现
+ */
+
+#include "fragment_cache.h"
+
+#include <algorithm>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace strreg {
+
+namespace {
+
+/// 键的第一个字节：查询种类
+const char kFindKind = 'F';
+const char kExtractKind = 'E';
+
+void appendNumber(std::string &key, std::uint64_t value) {
+  key.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+/**
+ * @brief 构造规范化的键
+ * 片段逐个以“长度 + 内容”写入，不同的片段划分不会得到相同的键
+ */
+void buildKey(std::string &key, char kind, std::string_view year,
+              std::uint64_t limit,
+              const std::vector<std::string_view> &fragments) {
+  key.clear();
+  key.push_back(kind);
+  key.append(year.data(), year.size());
+  appendNumber(key, limit);
+  for (std::string_view fragment : fragments) {
+    appendNumber(key, fragment.size());
+    key.append(fragment.data(), fragment.size());
+  }
+}
+
+/// FNV-1a 哈希，用于选择分片
+std::uint64_t hashKey(const std::string &key) {
+  std::uint64_t h = 14695981039346656037ull;
+  for (char c : key) {
+    h = (h ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+  }
+  return h;
+}
+
+std::size_t roundUpPowerOfTwo(std::size_t n) {
+  std::size_t result = 1;
+  while (result < n) {
+    result <<= 1;
+  }
+  return result;
+}
+
+} // namespace
+
+struct FragmentCache::Entry {
+  std::string key;
+  Clock::time_point expires;
+  Code code;
+  std::vector<std::string> codes;
+};
+
+struct FragmentCache::Shard {
+  std::mutex mutex;
+  /// 最近使用的条目在前
+  std::list<Entry> lru;
+  std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+};
+
+FragmentCache::FragmentCache() : FragmentCache(Options()) {}
+
+FragmentCache::FragmentCache(const Options &options) : options_(options) {
+  std::size_t count =
+      roundUpPowerOfTwo(std::max<std::size_t>(1, options.shards));
+  options_.shards = count;
+  shardCapacity_ =
+      std::max<std::size_t>(1, (options.capacity + count - 1) / count);
+  for (std::size_t i = 0; i < count; ++i) {
+    shards_.push_back(std::make_unique<Shard>());
+  }
+}
+
+FragmentCache::~FragmentCache() = default;
+
+FragmentCache::Shard &FragmentCache::shardFor(std::uint64_t hash) {
+  // 高位参与选择分片，低位留给分片内的哈希表
+  return *shards_[(hash >> 32) & (shards_.size() - 1)];
+}
+
+Code FragmentCache::find(const std::vector<std::string_view> &fragments,
+                         std::string_view year) {
+  thread_local std::string key;
+  buildKey(key, kFindKind, year, 0, fragments);
+  std::uint64_t hash = hashKey(key);
+  Code code;
+  if (lookup(key, hash, &code, nullptr)) {
+    return code;
+  }
+  code = findInFragments(fragments, year);
+  insert(key, hash, &code, nullptr);
+  return code;
+}
+
+std::vector<std::string>
+FragmentCache::extract(const std::vector<std::string_view> &fragments,
+                       std::string_view year, std::size_t limit) {
+  // 结果与片段顺序无关，按内容排序得到多重集合的规范形式
+  thread_local std::vector<std::string_view> sorted;
+  sorted.assign(fragments.begin(), fragments.end());
+  std::sort(sorted.begin(), sorted.end());
+
+  thread_local std::string key;
+  buildKey(key, kExtractKind, year, limit, sorted);
+  std::uint64_t hash = hashKey(key);
+  std::vector<std::string> codes;
+  if (lookup(key, hash, nullptr, &codes)) {
+    return codes;
+  }
+  codes = extractFromFragments(sorted, year, limit);
+  insert(key, hash, nullptr, &codes);
+  return codes;
+}
+
+bool FragmentCache::lookup(const std::string &key, std::uint64_t hash,
+                           Code *code, std::vector<std::string> *codes) {
+  Shard &shard = shardFor(hash);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto it = shard.index.find(key);
+  if (it == shard.index.end()) {
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  std::list<Entry>::iterator entry = it->second;
+  if (options_.ttl.count() > 0 && Clock::now() >= entry->expires) {
+    shard.index.erase(it);
+    shard.lru.erase(entry);
+    expirations_.fetch_add(1, std::memory_order_relaxed);
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  shard.lru.splice(shard.lru.begin(), shard.lru, entry);
+  if (code != nullptr) {
+    *code = entry->code;
+  }
+  if (codes != nullptr) {
+    *codes = entry->codes;
+  }
+  hits_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void FragmentCache::insert(const std::string &key, std::uint64_t hash,
+                           const Code *code,
+                           const std::vector<std::string> *codes) {
+  Shard &shard = shardFor(hash);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  // 另一个线程可能已经算出并插入了同一个键
+  if (shard.index.find(key) != shard.index.end()) {
+    return;
+  }
+  if (shard.lru.size() >= shardCapacity_) {
+    shard.index.erase(shard.lru.back().key);
+    shard.lru.pop_back();
+    evictions_.fetch_add(1, std::memory_order_relaxed);
+  }
+  shard.lru.emplace_front();
+  Entry &entry = shard.lru.front();
+  entry.key = key;
+  entry.expires = Clock::now() + options_.ttl;
+  if (code != nullptr) {
+    entry.code = *code;
+  }
+  if (codes != nullptr) {
+    entry.codes = *codes;
+  }
+  // 索引的键指向条目自己保存的字符串，条目被删除前一直有效
+  shard.index.emplace(entry.key, shard.lru.begin());
+}
+
+void FragmentCache::clear() {
+  for (std::unique_ptr<Shard> &shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    shard->index.clear();
+    shard->lru.clear();
+  }
+}
+
+FragmentCache::Stats FragmentCache::stats() const {
+  Stats stats;
+  stats.hits = hits_.load(std::memory_order_relaxed);
+  stats.misses = misses_.load(std::memory_order_relaxed);
+  stats.expirations = expirations_.load(std::memory_order_relaxed);
+  stats.evictions = evictions_.load(std::memory_order_relaxed);
+  for (const std::unique_ptr<Shard> &shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    stats.size += shard->lru.size();
+  }
+  return stats;
+}
+
+} // namespace strreg
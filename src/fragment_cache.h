@@ -0,0 +1,112 @@
+/**
+ * @file fragment_cache.h
+ * @brief 片段查询结果的有界 LRU 缓存
+ *
+ * 同一张标签被多次打印、识别时，相同的片段集合会反复出现。缓存以片段内容、
+ * 年份和查询种类为键保存结果，命中时直接返回，不再搜索。
+ *
+ * - 10位提取与片段顺序无关，键使用排序后的片段多重集合，顺序不同的同一组
+ *   片段共用一个条目；11位/8位搜索的结果取决于片段下标顺序，键保留原顺序
+ * - 条目数和存活时间都有上限，超出容量时淘汰最久未用的条目
+ * - 按键的哈希分成若干分片，每个分片一把锁，多个工作线程共用时竞争很小
+ */
+
+#ifndef STRREG_FRAGMENT_CACHE_H
+#define STRREG_FRAGMENT_CACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "fragments.h"
+
+namespace strreg {
+
+/**
+ * @brief 片段查询缓存
+ */
+class FragmentCache {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief 缓存参数
+   */
+  struct Options {
+    std::size_t capacity = 4096; ///< 最多保存的条目数
+    /// 条目的存活时间，为零时不过期
+    std::chrono::milliseconds ttl = std::chrono::milliseconds(0);
+    std::size_t shards = 16; ///< 分片数，会向上取到2的幂
+  };
+
+  /**
+   * @brief 统计计数
+   */
+  struct Stats {
+    std::uint64_t hits = 0;        ///< 命中次数
+    std::uint64_t misses = 0;      ///< 未命中次数（含过期）
+    std::uint64_t expirations = 0; ///< 因过期被丢弃的条目数
+    std::uint64_t evictions = 0;   ///< 因容量被淘汰的条目数
+    std::size_t size = 0;          ///< 当前条目数
+  };
+
+  FragmentCache();
+  explicit FragmentCache(const Options &options);
+  ~FragmentCache();
+  FragmentCache(const FragmentCache &) = delete;
+  FragmentCache &operator=(const FragmentCache &) = delete;
+
+  /**
+   * @brief 带缓存的 findInFragments
+   * @param fragments 字符串片段
+   * @param year 两位年份
+   * @return 与 findInFragments 相同
+   */
+  Code find(const std::vector<std::string_view> &fragments,
+            std::string_view year);
+
+  /**
+   * @brief 带缓存的 extractFromFragments
+   * @param fragments 字符串片段
+   * @param year 两位年份
+   * @param limit 最多返回的编码个数
+   * @return 与 extractFromFragments 相同
+   */
+  std::vector<std::string>
+  extract(const std::vector<std::string_view> &fragments,
+          std::string_view year, std::size_t limit = kAllFragmentHits);
+
+  /// 清空全部条目，计数不变
+  void clear();
+
+  /// 当前的统计计数
+  Stats stats() const;
+
+private:
+  struct Entry;
+  struct Shard;
+
+  /// 在 key 对应的分片中查找未过期的条目，命中时复制结果并返回true
+  bool lookup(const std::string &key, std::uint64_t hash, Code *code,
+              std::vector<std::string> *codes);
+  void insert(const std::string &key, std::uint64_t hash, const Code *code,
+              const std::vector<std::string> *codes);
+  Shard &shardFor(std::uint64_t hash);
+
+  Options options_;
+  std::size_t shardCapacity_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::atomic<std::uint64_t> hits_{0};
+  std::atomic<std::uint64_t> misses_{0};
+  std::atomic<std::uint64_t> expirations_{0};
+  std::atomic<std::uint64_t> evictions_{0};
+};
+
+} // namespace strreg
+
+#endif // STRREG_FRAGMENT_CACHE_H
@@ -0,0 +1,646 @@
+/**
+ * @file fragments.cpp
+ * @brief 片段拼接搜索引擎的实现
+ */
+
+#include "fragments.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "arena.h"
+#include "fixed_matcher.h"
+#include "metrics.h"
+#include "validator.h"
+#include "work_stealing.h"
+
+namespace strreg {
+
+namespace {
+
+/**
+ * @brief 拼接串末尾尚未完成的窗口
+ * 从最早一个仍可能匹配的起点到末尾的字符，长度小于规则长度
+ */
+struct Tail {
+  char data[FixedMatcher::kMaxLength] = {};
+  std::size_t length = 0;
+
+  bool empty() const { return length == 0; }
+  std::string_view view() const { return std::string_view(data, length); }
+  bool operator==(const Tail &other) const { return view() == other.view(); }
+};
+
+/// FNV-1a 哈希
+std::size_t hashBytes(const char *data, std::size_t length,
+                      std::uint64_t seed = 14695981039346656037ull) {
+  std::uint64_t h = seed;
+  for (std::size_t i = 0; i < length; ++i) {
+    h = (h ^ static_cast<unsigned char>(data[i])) * 1099511628211ull;
+  }
+  return static_cast<std::size_t>(h);
+}
+
+struct TailHash {
+  std::size_t operator()(const Tail &tail) const {
+    return hashBytes(tail.data, tail.length);
+  }
+};
+
+/**
+ * @brief 搜索状态：尾部字符加上已用片段集合
+ */
+struct State {
+  Tail tail;
+  std::uint64_t used = 0;
+
+  bool operator==(const State &other) const {
+    return used == other.used && tail == other.tail;
+  }
+};
+
+struct StateHash {
+  std::size_t operator()(const State &state) const {
+    return hashBytes(state.tail.data, state.tail.length,
+                     state.used * 0x9e3779b97f4a7c15ull);
+  }
+};
+
+template <class T> using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+/**
+ * @brief 逐片段推进的窗口状态机
+ * 非贪心模式报告所有匹配窗口（用于判断是否存在匹配）；
+ * 贪心模式与正则搜索一样，只报告从左到右互不重叠的匹配。
+ */
+class ChainScanner {
+public:
+  ChainScanner(const FixedMatcher &matcher, bool greedy, Arena &arena)
+      : matcher_(matcher), greedy_(greedy),
+        buffer_(ArenaAllocator<char>(arena)) {}
+
+  /**
+   * @brief 在状态 tail 之后追加片段
+   * @param tail 当前状态
+   * @param fragment 追加的片段
+   * @param onMatch 对每个完成的匹配调用 onMatch(std::string_view)
+   * @return 追加后的状态
+   */
+  template <class Fn>
+  Tail advance(const Tail &tail, std::string_view fragment, Fn onMatch) {
+    STRREG_COUNT(FragmentSteps, 1);
+    buffer_.assign(tail.data, tail.data + tail.length);
+    buffer_.insert(buffer_.end(), fragment.begin(), fragment.end());
+    const char *data = buffer_.data();
+    const std::size_t n = buffer_.size();
+    const std::size_t len = matcher_.length();
+
+    // 完整落在拼接串内的窗口已经可以判定
+    std::size_t next = 0;
+    for (std::size_t p = 0; p + len <= n; ++p) {
+      if (p >= next && matcher_.matchAt(data + p)) {
+        onMatch(std::string_view(data + p, len));
+        if (greedy_) {
+          next = p + len;
+        }
+      }
+    }
+
+    // 其余窗口尚未完成，新状态从其中最早一个仍可能匹配的起点开始
+    Tail result;
+    std::size_t p = n + 1 > len ? n + 1 - len : 0;
+    if (p < next) {
+      p = next;
+    }
+    for (; p < n; ++p) {
+      if (viable(data + p, n - p)) {
+        result.length = n - p;
+        std::memcpy(result.data, data + p, result.length);
+        break;
+      }
+    }
+    return result;
+  }
+
+  /**
+   * @brief 尾部中尚未完成的窗口能否再延长一个字符 c
+   * 所有窗口都不能接受 c 时，以 c 开头的片段会使这些窗口全部失效
+   */
+  bool extendable(const Tail &tail, unsigned char c) const {
+    for (std::size_t p = 0; p < tail.length; ++p) {
+      if (matcher_.allows(tail.length - p, c) &&
+          viable(tail.data + p, tail.length - p)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  /// 长度为 count 的字符串能否作为规则的前缀
+  bool viable(const char *str, std::size_t count) const {
+    for (std::size_t i = 0; i < count; ++i) {
+      if (!matcher_.allows(i, static_cast<unsigned char>(str[i]))) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  const FixedMatcher &matcher_;
+  bool greedy_;
+  ArenaVector<char> buffer_;
+};
+
+/**
+ * @brief 本层是否已经尝试过内容相同的片段
+ * 内容相同的片段互换位置得到的拼接结果相同，只需尝试下标最小的一个
+ */
+bool seenBefore(const std::vector<std::string_view> &fragments,
+                std::uint64_t used, std::size_t j) {
+  for (std::size_t i = 0; i < j; ++i) {
+    if (!(used >> i & 1u) && fragments[i] == fragments[j]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief 判断从某个状态出发，用剩余片段能否拼出匹配
+ */
+class Reachability {
+public:
+  Reachability(const std::vector<std::string_view> &fragments,
+               const FixedMatcher &matcher, Arena &arena)
+      : fragments_(fragments), scanner_(matcher, false, arena),
+        memo_(0, StateHash(), std::equal_to<State>(),
+              ArenaAllocator<std::pair<const State, bool>>(arena)) {}
+
+  /**
+   * @param tail 当前状态
+   * @param used 已用片段集合
+   * @return 存在某种剩余片段的排列使拼接结果含有匹配时返回true
+   */
+  bool reachable(const Tail &tail, std::uint64_t used) {
+    if (cancelled()) {
+      return false;
+    }
+    // 尾部之后接上任意片段链，链内的窗口依然存在，
+    // 所以空状态能做到的，任何状态都能做到
+    if (!tail.empty() && reachable(Tail(), used)) {
+      return true;
+    }
+
+    State key{tail, used};
+    auto it = memo_.find(key);
+    if (it != memo_.end()) {
+      return it->second;
+    }
+
+    bool result = false;
+    for (std::size_t j = 0; j < fragments_.size() && !result; ++j) {
+      if ((used >> j & 1u) || fragments_[j].empty() ||
+          seenBefore(fragments_, used, j)) {
+        continue;
+      }
+      bool hit = false;
+      Tail next = scanner_.advance(tail, fragments_[j],
+                                   [&](std::string_view) { hit = true; });
+      // 状态回到空时，之后能做到的已包含在空状态的结果中
+      result = hit || (!next.empty() &&
+                       reachable(next, used | (std::uint64_t(1) << j)));
+    }
+    memo_.emplace(key, result);
+    return result;
+  }
+
+  ChainScanner &scanner() { return scanner_; }
+
+  /**
+   * @brief 设置取消条件：*best 小于 rank 时放弃搜索
+   * 并行搜索中更小的下标已经成功时，本任务的结果不再有意义
+   */
+  void cancelWhen(const std::atomic<std::size_t> *best, std::size_t rank) {
+    best_ = best;
+    rank_ = rank;
+  }
+
+private:
+  bool cancelled() const {
+    return best_ != nullptr && best_->load(std::memory_order_relaxed) < rank_;
+  }
+
+  const std::vector<std::string_view> &fragments_;
+  ChainScanner scanner_;
+  std::unordered_map<State, bool, StateHash, std::equal_to<State>,
+                     ArenaAllocator<std::pair<const State, bool>>>
+      memo_;
+  const std::atomic<std::size_t> *best_ = nullptr;
+  std::size_t rank_ = 0;
+};
+
+/**
+ * @brief 在当前状态之后选出下一个片段：能完成匹配的最小下标
+ * @param search 可达性搜索
+ * @param tail 当前状态，选中时更新为追加该片段后的状态
+ * @param used 已用片段集合
+ * @param hit 选中的片段追加后是否已经含有匹配
+ * @return 选中的下标；没有能完成匹配的片段时返回片段数
+ */
+std::size_t chooseNext(Reachability &search,
+                       const std::vector<std::string_view> &fragments,
+                       Tail &tail, std::uint64_t used, bool &hit) {
+  const std::size_t n = fragments.size();
+  for (std::size_t j = 0; j < n; ++j) {
+    if ((used >> j & 1u) || seenBefore(fragments, used, j)) {
+      continue;
+    }
+    bool hitHere = false;
+    Tail next = search.scanner().advance(
+        tail, fragments[j], [&](std::string_view) { hitHere = true; });
+    if (hitHere || search.reachable(next, used | (std::uint64_t(1) << j))) {
+      tail = next;
+      hit = hitHere;
+      return j;
+    }
+  }
+  return n;
+}
+
+/**
+ * @brief 并行版本的 chooseNext：每个候选下标一个任务
+ * 某个下标成功后，更大下标的任务协作式地放弃；等所有更小下标的任务完成，
+ * 成功的最小下标就是顺序版本的选择
+ */
+std::size_t chooseNextParallel(const std::vector<std::string_view> &fragments,
+                               const FixedMatcher &matcher, Tail &tail,
+                               std::uint64_t used, bool &hit,
+                               WorkStealingPool &pool) {
+  struct Candidate {
+    Tail next;
+    bool hit = false;
+  };
+  const std::size_t n = fragments.size();
+  std::vector<Candidate> candidates(n);
+  std::atomic<std::size_t> best(n);
+  const Tail start = tail;
+  {
+    TaskGroup group(pool);
+    for (std::size_t j = 0; j < n; ++j) {
+      if ((used >> j & 1u) || seenBefore(fragments, used, j)) {
+        continue;
+      }
+      group.spawn([&, j] {
+        if (best.load(std::memory_order_relaxed) < j) {
+          return;
+        }
+        Arena &arena = threadArena();
+        ArenaScope scope(arena);
+        Reachability search(fragments, matcher, arena);
+        search.cancelWhen(&best, j);
+        Candidate &candidate = candidates[j];
+        candidate.next = search.scanner().advance(
+            start, fragments[j],
+            [&](std::string_view) { candidate.hit = true; });
+        if (candidate.hit ||
+            search.reachable(candidate.next, used | (std::uint64_t(1) << j))) {
+          std::size_t current = best.load(std::memory_order_relaxed);
+          while (j < current && !best.compare_exchange_weak(current, j)) {
+          }
+        }
+      });
+    }
+    group.wait();
+  }
+  std::size_t chosen = best.load();
+  if (chosen != n) {
+    tail = candidates[chosen].next;
+    hit = candidates[chosen].hit;
+  }
+  return chosen;
+}
+
+/**
+ * @brief 多个线程共用的10位结果集合
+ */
+class SharedHits {
+public:
+  explicit SharedHits(std::size_t limit) : limit_(limit) {}
+
+  void insert(std::string_view match) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (codes_.size() < limit_) {
+      codes_.emplace(match);
+      if (codes_.size() >= limit_) {
+        full_.store(true, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool full() const { return full_.load(std::memory_order_relaxed); }
+
+  std::vector<std::string> results() const {
+    return std::vector<std::string>(codes_.begin(), codes_.end());
+  }
+
+private:
+  std::size_t limit_;
+  std::mutex mutex_;
+  std::set<std::string> codes_;
+  std::atomic<bool> full_{false};
+};
+
+/**
+ * @brief 贪心模式下收集所有可能被正则搜索报告的匹配
+ */
+class Collector {
+public:
+  /**
+   * @param fragments 片段
+   * @param matcher 10位规则的匹配器
+   * @param arena 中间数据使用的内存池
+   * @param limit 收集到这么多个不同的匹配后停止搜索
+   * @param shared 非空时匹配写入多个线程共用的集合，limit 由该集合决定
+   */
+  Collector(const std::vector<std::string_view> &fragments,
+            const FixedMatcher &matcher, Arena &arena, std::size_t limit,
+            SharedHits *shared = nullptr)
+      : arena_(arena), fragments_(fragments), limit_(limit), shared_(shared),
+        scanner_(matcher, true, arena),
+        results_(std::less<std::string_view>(),
+                 ArenaAllocator<std::string_view>(arena)),
+        visited_(0, TailHash(), std::equal_to<Tail>(),
+                 ArenaAllocator<VisitedMap::value_type>(arena)) {}
+
+  void explore(const Tail &tail, std::uint64_t used) {
+    for (std::size_t j = 0; j < fragments_.size() && !full(); ++j) {
+      Tail next;
+      if (eligible(used, j) && step(tail, used, j, next)) {
+        explore(next, used | (std::uint64_t(1) << j));
+      }
+    }
+  }
+
+  /// 片段 j 能否在已用集合 used 之后追加
+  bool eligible(std::uint64_t used, std::size_t j) const {
+    return !(used >> j & 1u) && !fragments_[j].empty() &&
+           !seenBefore(fragments_, used, j);
+  }
+
+  /**
+   * @brief 在状态 tail 之后追加片段 j 并记录完成的匹配
+   * @param next 追加后的状态
+   * @return 需要继续向下搜索时返回true
+   */
+  bool step(const Tail &tail, std::uint64_t used, std::size_t j, Tail &next) {
+    next = scanner_.advance(tail, fragments_[j],
+                            [&](std::string_view m) { insert(m); });
+    std::uint64_t nextUsed = used | (std::uint64_t(1) << j);
+    // 状态回到空，或尾部的窗口无法被任何剩余片段延长时，
+    // 之后的结果已包含在从头开始的搜索中
+    return !full() && !next.empty() && extendable(next, nextUsed) &&
+           !dominated(next, nextUsed);
+  }
+
+  std::vector<std::string> results() const {
+    std::vector<std::string> out;
+    out.reserve(results_.size());
+    for (std::string_view result : results_) {
+      out.emplace_back(result);
+    }
+    return out;
+  }
+
+private:
+  bool full() const {
+    return shared_ != nullptr ? shared_->full() : results_.size() >= limit_;
+  }
+
+  /// 是否有剩余片段的首字符能延长尾部中的某个窗口
+  bool extendable(const Tail &tail, std::uint64_t used) const {
+    for (std::size_t j = 0; j < fragments_.size(); ++j) {
+      if (!(used >> j & 1u) && !fragments_[j].empty() &&
+          scanner_.extendable(
+              tail, static_cast<unsigned char>(fragments_[j][0]))) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief 同一尾部若曾以更少的已用片段访问过，本次能得到的结果都已得到
+   * 未访问过时记录本次访问
+   */
+  bool dominated(const Tail &tail, std::uint64_t used) {
+    ArenaVector<std::uint64_t> &seen =
+        visited_
+            .try_emplace(tail, ArenaAllocator<std::uint64_t>(arena_))
+            .first->second;
+    for (std::uint64_t mask : seen) {
+      if ((mask & ~used) == 0) {
+        return true;
+      }
+    }
+    seen.push_back(used);
+    return false;
+  }
+
+  /// 记录一个匹配；匹配的字符复制到内存池中，扫描缓冲区之后可以被覆盖
+  void insert(std::string_view match) {
+    if (shared_ != nullptr) {
+      shared_->insert(match);
+      return;
+    }
+    if (full() || results_.find(match) != results_.end()) {
+      return;
+    }
+    char *copy = static_cast<char *>(arena_.allocate(match.size(), 1));
+    std::memcpy(copy, match.data(), match.size());
+    results_.insert(std::string_view(copy, match.size()));
+  }
+
+  /// 尾部 -> 曾以哪些已用片段集合访问过
+  using VisitedMap = std::unordered_map<
+      Tail, ArenaVector<std::uint64_t>, TailHash, std::equal_to<Tail>,
+      ArenaAllocator<std::pair<const Tail, ArenaVector<std::uint64_t>>>>;
+
+  Arena &arena_;
+  const std::vector<std::string_view> &fragments_;
+  std::size_t limit_;
+  SharedHits *shared_;
+  ChainScanner scanner_;
+  std::set<std::string_view, std::less<std::string_view>,
+           ArenaAllocator<std::string_view>>
+      results_;
+  VisitedMap visited_;
+};
+
+/**
+ * @brief findInFragments 的实现，pool 为空时完全顺序执行
+ */
+Code searchFragments(const std::vector<std::string_view> &fragments,
+                     std::string_view year, WorkStealingPool *pool) {
+  STRREG_TIME(Fragments);
+  Code code;
+  const std::size_t n = fragments.size();
+  if (year.length() != 2 || n > kMaxFragments) {
+    return code;
+  }
+
+  // 查询内的全部中间数据都取自本线程的内存池，返回时整体回收
+  Arena &arena = threadArena();
+  ArenaScope scope(arena);
+
+  // 11位匹配的前8位一定是8位匹配，所以“排列中有匹配”等价于“有8位匹配”
+  const FixedMatcher &matcher =
+      getValidator(RuleId::Code8, year, Engine::Table).matcher();
+  Reachability search(fragments, matcher, arena);
+
+  // 按下标字典序逐位选择：每一位选能完成匹配的最小下标，
+  // 得到的就是字典序最小的含有匹配的排列
+  ArenaVector<std::size_t> order{ArenaAllocator<std::size_t>(arena)};
+  order.reserve(n);
+  std::uint64_t used = 0;
+  Tail tail;
+  bool hit = false;
+  while (order.size() < n && !hit) {
+    // 剩余片段较多时每个候选下标交给一个任务，较少时顺序搜索更快
+    std::size_t chosen =
+        pool != nullptr && n - order.size() >= kParallelFragments
+            ? chooseNextParallel(fragments, matcher, tail, used, hit, *pool)
+            : chooseNext(search, fragments, tail, used, hit);
+    if (chosen == n) {
+      return code;
+    }
+    order.push_back(chosen);
+    used |= std::uint64_t(1) << chosen;
+  }
+  if (!hit) {
+    return code;
+  }
+  // 前缀中已有匹配，其余片段按下标顺序排列即可
+  for (std::size_t j = 0; j < n; ++j) {
+    if (!(used >> j & 1u)) {
+      order.push_back(j);
+    }
+  }
+
+  ArenaVector<char> combined{ArenaAllocator<char>(arena)};
+  for (std::size_t index : order) {
+    combined.insert(combined.end(), fragments[index].begin(),
+                    fragments[index].end());
+  }
+  Match match =
+      extractValid(std::string_view(combined.data(), combined.size()), year);
+  if (match) {
+    std::memcpy(code.data, combined.data() + match.offset, match.length);
+    code.length = match.length;
+    code.rule = match.rule;
+  }
+  return code;
+}
+
+/**
+ * @brief 并行收集10位匹配：每个 (第一个片段, 第二个片段) 组合一个任务
+ * 各任务的子树彼此独立，结果写入共用的集合；达到 limit 后所有任务停止
+ */
+std::vector<std::string>
+collectParallel(const std::vector<std::string_view> &fragments,
+                const FixedMatcher &matcher, std::size_t limit,
+                WorkStealingPool &pool) {
+  const std::size_t n = fragments.size();
+  SharedHits shared(limit);
+  std::vector<Tail> heads(n);
+  Arena &arena = threadArena();
+  ArenaScope scope(arena);
+  Collector root(fragments, matcher, arena, limit, &shared);
+  TaskGroup group(pool);
+  for (std::size_t j = 0; j < n && !shared.full(); ++j) {
+    if (!root.eligible(0, j) || !root.step(Tail(), 0, j, heads[j])) {
+      continue;
+    }
+    const std::uint64_t used = std::uint64_t(1) << j;
+    for (std::size_t k = 0; k < n; ++k) {
+      if (!root.eligible(used, k)) {
+        continue;
+      }
+      group.spawn([&, used, j, k] {
+        if (shared.full()) {
+          return;
+        }
+        Arena &taskArena = threadArena();
+        ArenaScope taskScope(taskArena);
+        Collector collector(fragments, matcher, taskArena, limit, &shared);
+        Tail next;
+        if (collector.step(heads[j], used, k, next)) {
+          collector.explore(next, used | (std::uint64_t(1) << k));
+        }
+      });
+    }
+  }
+  group.wait();
+  return shared.results();
+}
+
+} // namespace
+
+Code findInFragments(const std::vector<std::string_view> &fragments,
+                     std::string_view year) {
+  return searchFragments(fragments, year, nullptr);
+}
+
+Code findInFragments(const std::vector<std::string_view> &fragments,
+                     std::string_view year, WorkStealingPool &pool) {
+  return searchFragments(fragments, year, pool.size() > 1 ? &pool : nullptr);
+}
+
+std::vector<std::string>
+extractFromFragments(const std::vector<std::string_view> &fragments,
+                     std::string_view year, WorkStealingPool &pool,
+                     std::size_t limit) {
+  // 限定个数时要的是按搜索顺序最先找到的编码，并行任务的完成顺序
+  // 取决于线程调度，这时顺序搜索
+  if (fragments.size() < kParallelFragments || pool.size() < 2 ||
+      limit != kAllFragmentHits) {
+    return extractFromFragments(fragments, year, limit);
+  }
+  STRREG_TIME(Fragments);
+  if (year.length() != 2 || fragments.size() > kMaxFragments || limit == 0) {
+    return std::vector<std::string>();
+  }
+  const FixedMatcher &matcher =
+      getValidator(RuleId::Code10, year, Engine::Table).matcher();
+  std::vector<std::string> codes =
+      collectParallel(fragments, matcher, limit, pool);
+  STRREG_COUNT(MatchesCode10, codes.size());
+  return codes;
+}
+
+std::vector<std::string>
+extractFromFragments(const std::vector<std::string_view> &fragments,
+                     std::string_view year, std::size_t limit) {
+  STRREG_TIME(Fragments);
+  if (year.length() != 2 || fragments.size() > kMaxFragments || limit == 0) {
+    return std::vector<std::string>();
+  }
+  Arena &arena = threadArena();
+  ArenaScope scope(arena);
+  const FixedMatcher &matcher =
+      getValidator(RuleId::Code10, year, Engine::Table).matcher();
+  Collector collector(fragments, matcher, arena, limit);
+  collector.explore(Tail(), 0);
+  std::vector<std::string> codes = collector.results();
+  STRREG_COUNT(MatchesCode10, codes.size());
+  return codes;
+}
+
+} // namespace strreg
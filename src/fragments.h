@@ -0,0 +1,94 @@
+/**
+ * @file fragments.h
+ * @brief 片段拼接搜索引擎
+ *
+ * 匹配最长只有11个字符，因此拼接结果是否含有匹配只取决于“尚未完成的
+ * 窗口”和还没用过的片段。搜索以 (未完成窗口的尾部, 已用片段集合) 为状态，
+ * 一次追加一个片段，尾部不可能再形成匹配时立即剪枝，不再枚举全部 n! 种排列。
+ */
+
+#ifndef STRREG_FRAGMENTS_H
+#define STRREG_FRAGMENTS_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "extract.h"
+
+namespace strreg {
+
+/// 片段搜索支持的最大片段数
+constexpr std::size_t kMaxFragments = 64;
+
+/// 并行版本在片段数（或剩余片段数）不少于该值时才分派任务
+constexpr std::size_t kParallelFragments = 8;
+
+class WorkStealingPool;
+
+/**
+ * @brief 从多个字符串片段的排列中找出符合11位或8位规则的字符串
+ * 结果与按片段下标字典序逐个尝试全部排列、返回第一个含有匹配的排列中
+ * extractValid 的结果完全相同
+ *
+ * @param fragments 字符串片段，最多 kMaxFragments 个
+ * @param year 两位年份
+ * @return 找到的编码；未找到、片段过多或年份不是两位时 found() 为false
+ */
+Code findInFragments(const std::vector<std::string_view> &fragments,
+                     std::string_view year);
+
+/**
+ * @brief findInFragments 的并行版本，结果与顺序版本完全相同
+ * 每一位的各个候选下标由线程池中的任务并行判断，较小的下标成功后，
+ * 较大下标的任务立即放弃；剩余片段少于 kParallelFragments 时顺序搜索
+ *
+ * @param fragments 字符串片段，最多 kMaxFragments 个
+ * @param year 两位年份
+ * @param pool 执行任务的线程池
+ */
+Code findInFragments(const std::vector<std::string_view> &fragments,
+                     std::string_view year, WorkStealingPool &pool);
+
+/// extractFromFragments 不限制结果个数
+constexpr std::size_t kAllFragmentHits = static_cast<std::size_t>(-1);
+
+/**
+ * @brief 从片段的任意排列、任意子集拼接结果中提取所有10位（小端面）编码
+ * 结果与对每种排列的每种子集拼接结果做从左到右不重叠的正则搜索、
+ * 再排序去重完全相同
+ *
+ * 指定 limit 时，搜索在找到 limit 个不同的编码后立即停止，返回的是完整结果
+ * 的一个子集（按搜索顺序最先找到的那些，排序后返回），适合只需要少量命中的
+ * 在线查询
+ *
+ * @param fragments 字符串片段，最多 kMaxFragments 个
+ * @param year 两位年份
+ * @param limit 最多返回的编码个数
+ * @return 排序去重后的编码列表
+ */
+std::vector<std::string>
+extractFromFragments(const std::vector<std::string_view> &fragments,
+                     std::string_view year,
+                     std::size_t limit = kAllFragmentHits);
+
+/**
+ * @brief extractFromFragments 的并行版本
+ * 搜索树按 (第一个片段, 第二个片段) 切成任务交给线程池，结果与顺序版本
+ * 完全相同。指定 limit 时结果取决于搜索顺序，与顺序版本一样顺序搜索；
+ * 片段少于 kParallelFragments 时也顺序搜索
+ *
+ * @param fragments 字符串片段，最多 kMaxFragments 个
+ * @param year 两位年份
+ * @param pool 执行任务的线程池
+ * @param limit 最多返回的编码个数
+ */
+std::vector<std::string>
+extractFromFragments(const std::vector<std::string_view> &fragments,
+                     std::string_view year, WorkStealingPool &pool,
+                     std::size_t limit = kAllFragmentHits);
+
+} // namespace strreg
+
+#endif // STRREG_FRAGMENTS_H
@@ -0,0 +1,104 @@
+/**
+ * @file fuzz.cpp
+ * @brief 兼容 libFuzzer 的差分模糊测试入口（strreg_fuzz）
+ *
+ * 输入格式：第1个字节选择模式（偶数为记录，奇数为片段），第2、3个字节
+ * 映射为一个字母数字年份，其余字节是记录本身，或按 0x1f 切分的至多4个片段。
+ * 任何不一致都会打印详情并 abort()，由 libFuzzer 保存触发输入。
+ *
+ * 非 Clang 编译器没有 libFuzzer，此时定义 STRREG_FUZZ_STANDALONE，
+ * 生成的程序依次读取命令行给出的文件并回放，用于在 ASan/UBSan 下复现问题。
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "differential.h"
+
+namespace {
+
+/// 片段之间的分隔字节
+const char kFragmentSeparator = '\x1f';
+/// 片段模式下最多使用的片段数
+const std::size_t kMaxFuzzFragments = 4;
+
+char yearChar(std::uint8_t byte) {
+  static const char kChars[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghij"
+                               "klmnopqrstuvwxyz";
+  // 偏向数字，使规则更容易命中
+  if (byte < 0xc0) {
+    return static_cast<char>('0' + byte % 10);
+  }
+  return kChars[byte % (sizeof(kChars) - 1)];
+}
+
+void report(const strreg::DifferentialChecker &checker) {
+  for (const strreg::Mismatch &m : checker.mismatches()) {
+    std::fprintf(stderr, "错误：%s 输入 \"%s\" 期望 %s 实际 %s\n",
+                 m.check.c_str(), m.input.c_str(), m.expected.c_str(),
+                 m.actual.c_str());
+  }
+}
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t *data,
+                                      std::size_t size) {
+  if (size < 3) {
+    return 0;
+  }
+  const char year[2] = {yearChar(data[1]), yearChar(data[2])};
+  const std::string body(reinterpret_cast<const char *>(data) + 3, size - 3);
+
+  strreg::DifferentialChecker checker;
+  if ((data[0] & 1) == 0) {
+    checker.checkRecord(body, std::string_view(year, 2));
+  } else {
+    std::vector<std::string> fragments;
+    std::size_t start = 0;
+    while (fragments.size() + 1 < kMaxFuzzFragments) {
+      std::size_t end = body.find(kFragmentSeparator, start);
+      if (end == std::string::npos) {
+        break;
+      }
+      fragments.push_back(body.substr(start, end - start));
+      start = end + 1;
+    }
+    fragments.push_back(body.substr(start));
+    checker.checkFragments(fragments, std::string_view(year, 2));
+  }
+
+  if (checker.failures() != 0) {
+    report(checker);
+    std::abort();
+  }
+  return 0;
+}
+
+#ifdef STRREG_FUZZ_STANDALONE
+
+int main(int argc, char *argv[]) {
+  for (int i = 1; i < argc; ++i) {
+    std::FILE *file = std::fopen(argv[i], "rb");
+    if (file == nullptr) {
+      std::fprintf(stderr, "错误：无法打开文件 %s\n", argv[i]);
+      return 1;
+    }
+    std::vector<std::uint8_t> data;
+    std::uint8_t buffer[4096];
+    std::size_t n;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+      data.insert(data.end(), buffer, buffer + n);
+    }
+    std::fclose(file);
+    LLVMFuzzerTestOneInput(data.data(), data.size());
+  }
+  std::printf("已回放 %d 个输入\n", argc - 1);
+  return 0;
+}
+
+#endif // STRREG_FUZZ_STANDALONE
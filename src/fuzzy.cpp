@@ -0,0 +1,271 @@
+/**
+ * @file fuzzy.cpp
+ * @brief 容忍 OCR 误识的近似提取的实现
+ */
+
+#include "fuzzy.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "metrics.h"
+
+namespace strreg {
+
+namespace {
+
+const std::size_t kMaxWords =
+    (FuzzyScanner::kMaxRules * FixedMatcher::kMaxLength + 63) / 64;
+
+} // namespace
+
+ConfusionTable::ConfusionTable() {
+  std::memset(subs_, 0, sizeof(subs_));
+  std::memset(count_, 0, sizeof(count_));
+}
+
+ConfusionTable ConfusionTable::ocr() {
+  ConfusionTable table;
+  table.parse("O0,I1,S5,B8");
+  return table;
+}
+
+bool ConfusionTable::add(unsigned char a, unsigned char b) {
+  if (a == b) {
+    return true;
+  }
+  if (substitutes(a).find(static_cast<char>(b)) != std::string_view::npos) {
+    return true;
+  }
+  if (count_[a] == kMaxSubstitutes || count_[b] == kMaxSubstitutes) {
+    return false;
+  }
+  subs_[a][count_[a]++] = static_cast<char>(b);
+  subs_[b][count_[b]++] = static_cast<char>(a);
+  return true;
+}
+
+bool ConfusionTable::parse(std::string_view spec) {
+  ConfusionTable table;
+  while (!spec.empty()) {
+    std::size_t comma = spec.find(',');
+    std::string_view pair = spec.substr(0, comma);
+    if (pair.length() != 2 ||
+        !table.add(static_cast<unsigned char>(pair[0]),
+                   static_cast<unsigned char>(pair[1]))) {
+      return false;
+    }
+    if (comma == std::string_view::npos) {
+      break;
+    }
+    spec.remove_prefix(comma + 1);
+  }
+  *this = table;
+  return true;
+}
+
+FuzzyScanner::FuzzyScanner(const RuleId *rules, std::size_t count,
+                           const YearSet &years, const ConfusionTable &table,
+                           std::size_t maxErrors)
+    : rules_(rules, rules + std::min(count, kMaxRules)), years_(years),
+      table_(table), maxErrors_(std::min(maxErrors, kMaxErrors)) {
+  std::size_t bits = 0;
+  for (RuleId rule : rules_) {
+    matchers_.push_back(FixedMatcher::compile(rule, years_));
+    bits += matchers_.back().length();
+  }
+  words_ = std::max<std::size_t>(1, (bits + 63) / 64);
+  exactMasks_.assign(256 * words_, 0);
+  substMasks_.assign(256 * words_, 0);
+  startMask_.assign(words_, 0);
+
+  // 状态位的排列与 AutomatonScanner 相同：规则 r 的第 p 位占 base + p。
+  // 字节 c 不被第 p 位允许、但可替换成允许的字节时，置在替换掩码中
+  std::size_t base = 0;
+  for (const FixedMatcher &m : matchers_) {
+    startMask_[base / 64] |= std::uint64_t(1) << (base % 64);
+    for (std::size_t pos = 0; pos < m.length(); ++pos) {
+      std::size_t bit = base + pos;
+      std::uint64_t mask = std::uint64_t(1) << (bit % 64);
+      for (unsigned c = 0; c < 256; ++c) {
+        if (m.allows(pos, static_cast<unsigned char>(c))) {
+          exactMasks_[c * words_ + bit / 64] |= mask;
+          continue;
+        }
+        for (char s : table_.substitutes(static_cast<unsigned char>(c))) {
+          if (m.allows(pos, static_cast<unsigned char>(s))) {
+            substMasks_[c * words_ + bit / 64] |= mask;
+            break;
+          }
+        }
+      }
+    }
+    base += m.length();
+    finalBit_.push_back(base - 1);
+  }
+}
+
+bool FuzzyScanner::correct(const char *window, std::size_t r,
+                           std::size_t offset, FuzzyMatch &out) const {
+  const FixedMatcher &m = matchers_[r];
+  const std::size_t length = m.length();
+  std::size_t cost = 0;
+
+  // 年份以外的各位互不影响，每位取原字节或第一个允许的混淆字符
+  for (std::size_t pos = 2; pos < length; ++pos) {
+    const unsigned char c = static_cast<unsigned char>(window[pos]);
+    char fixed = static_cast<char>(c);
+    if (!m.allows(pos, c)) {
+      fixed = 0;
+      for (char s : table_.substitutes(c)) {
+        if (m.allows(pos, static_cast<unsigned char>(s))) {
+          fixed = s;
+          break;
+        }
+      }
+      if (fixed == 0 || ++cost > maxErrors_) {
+        return false;
+      }
+    }
+    out.corrected[pos] = fixed;
+  }
+
+  // 年份两位要合起来在集合中，逐个尝试两位的候选，取替换最少的组合
+  char candidates[2][ConfusionTable::kMaxSubstitutes + 1];
+  std::size_t counts[2] = {0, 0};
+  for (std::size_t pos = 0; pos < 2; ++pos) {
+    const unsigned char c = static_cast<unsigned char>(window[pos]);
+    candidates[pos][counts[pos]++] = static_cast<char>(c);
+    for (char s : table_.substitutes(c)) {
+      candidates[pos][counts[pos]++] = s;
+    }
+  }
+  std::size_t best = maxErrors_ - cost + 1;
+  std::size_t year = YearSet::npos;
+  for (std::size_t a = 0; a < counts[0]; ++a) {
+    for (std::size_t b = 0; b < counts[1]; ++b) {
+      const char prefix[2] = {candidates[0][a], candidates[1][b]};
+      const std::size_t extra = (a != 0) + (b != 0);
+      std::size_t index = years_.indexOf(prefix);
+      if (extra < best && index != YearSet::npos) {
+        best = extra;
+        year = index;
+        out.corrected[0] = prefix[0];
+        out.corrected[1] = prefix[1];
+      }
+    }
+  }
+  if (year == YearSet::npos) {
+    return false;
+  }
+
+  out.match.offset = offset;
+  out.match.length = length;
+  out.match.rule = rules_[r];
+  out.match.year = year;
+  out.cost = cost + best;
+  return true;
+}
+
+std::size_t FuzzyScanner::findAll(std::string_view input,
+                                  std::vector<FuzzyMatch> &out) const {
+  const std::size_t before = out.size();
+  std::size_t maxLength = 0;
+  for (const FixedMatcher &m : matchers_) {
+    maxLength = std::max(maxLength, m.length());
+  }
+  if (maxLength == 0) {
+    return 0;
+  }
+  STRREG_COUNT(BytesScanned, input.length());
+
+  // state[j] 为至多 j 处替换即可到达的状态；自动机只负责找出候选窗口，
+  // 替换数和改法由 correct 在窗口上精确计算（年份两位须合起来在集合中）
+  std::uint64_t state[kMaxErrors + 1][kMaxWords] = {};
+  const std::size_t k = maxErrors_;
+  const std::size_t kRing = FixedMatcher::kMaxLength;
+  std::uint32_t pending[kRing] = {};
+  auto flush = [&](std::size_t start) {
+    std::uint32_t &rules = pending[start & (kRing - 1)];
+    for (std::size_t r = 0; rules != 0; ++r, rules >>= 1) {
+      FuzzyMatch match;
+      if ((rules & 1u) && correct(input.data() + start, r, start, match)) {
+        out.push_back(match);
+      }
+    }
+  };
+
+  for (std::size_t i = 0; i < input.length(); ++i) {
+    const unsigned char c = static_cast<unsigned char>(input[i]);
+    const std::uint64_t *exact = &exactMasks_[c * words_];
+    const std::uint64_t *subst = &substMasks_[c * words_];
+    // 从错误数多的一层往下算，算第 j 层时第 j-1 层还是上一个字节的状态
+    for (std::size_t j = k + 1; j-- > 0;) {
+      std::uint64_t carry = 0;
+      std::uint64_t lowerCarry = 0;
+      for (std::size_t w = 0; w < words_; ++w) {
+        std::uint64_t shifted = (state[j][w] << 1) | carry | startMask_[w];
+        std::uint64_t next = shifted & exact[w];
+        carry = state[j][w] >> 63;
+        if (j > 0) {
+          std::uint64_t lower =
+              (state[j - 1][w] << 1) | lowerCarry | startMask_[w];
+          next |= lower & subst[w];
+          lowerCarry = state[j - 1][w] >> 63;
+        }
+        state[j][w] = next;
+      }
+    }
+    for (std::size_t r = 0; r < finalBit_.size(); ++r) {
+      std::size_t bit = finalBit_[r];
+      if ((state[k][bit / 64] >> (bit % 64)) & 1u) {
+        pending[(i + 1 - matchers_[r].length()) & (kRing - 1)] |=
+            std::uint32_t(1) << r;
+      }
+    }
+    if (i + 1 >= maxLength) {
+      flush(i + 1 - maxLength);
+    }
+  }
+  const std::size_t len = input.length();
+  for (std::size_t start = len >= maxLength ? len - maxLength + 1 : 0;
+       start < len; ++start) {
+    flush(start);
+  }
+  return out.size() - before;
+}
+
+FuzzyMatch FuzzyScanner::extract(std::string_view input) const {
+  thread_local std::vector<FuzzyMatch> matches;
+  matches.clear();
+  findAll(input, matches);
+
+  auto rank = [&](RuleId rule) {
+    return static_cast<std::size_t>(
+        std::find(rules_.begin(), rules_.end(), rule) - rules_.begin());
+  };
+  FuzzyMatch best;
+  std::size_t bestRank = rules_.size();
+  for (const FuzzyMatch &match : matches) {
+    // 结果已按偏移排列，同一规则、同样替换数时保留先出现的
+    std::size_t r = rank(match.match.rule);
+    if (r < bestRank || (r == bestRank && match.cost < best.cost)) {
+      best = match;
+      bestRank = r;
+    }
+  }
+  return best;
+}
+
+FuzzyMatch FuzzyScanner::validate(std::string_view record) const {
+  FuzzyMatch match;
+  for (std::size_t r = 0; r < matchers_.size(); ++r) {
+    if (record.length() == matchers_[r].length() &&
+        correct(record.data(), r, 0, match)) {
+      return match;
+    }
+  }
+  return FuzzyMatch();
+}
+
+} // namespace strreg
@@ -0,0 +1,153 @@
+/**
+ * @file fuzzy.h
+ * @brief 容忍 OCR 误识的近似提取
+ *
+ * OCR 常把形近字符认错（O/0、I/1、S/5、B/8），编码差一个字符就不再符合
+ * 规则。近似扫描器允许至多 k 处按混淆表的替换：把规则放进位并行的非确定
+ * 自动机，另外为 0..k 个错误各保留一组状态位，读入一个字节时，
+ * 能按原字节前进的状态留在原错误数，只能按混淆字符前进的状态错误数加一。
+ * 一趟扫描即可找出所有 k 个替换以内的匹配，不枚举候选变体。
+ */
+
+#ifndef STRREG_FUZZY_H
+#define STRREG_FUZZY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "extract.h"
+#include "fixed_matcher.h"
+#include "years.h"
+
+namespace strreg {
+
+/**
+ * @brief 混淆表：每个字节可能被误识成的其他字节
+ */
+class ConfusionTable {
+public:
+  /// 每个字节最多的混淆字符数
+  static const std::size_t kMaxSubstitutes = 4;
+
+  /// 空表，不允许任何替换
+  ConfusionTable();
+
+  /// 默认的 OCR 混淆表：O0、I1、S5、B8
+  static ConfusionTable ocr();
+
+  /**
+   * @brief 加入一对互相混淆的字节，两个方向都允许替换
+   * @return 两个字节都还能容纳新的混淆字符时返回true
+   */
+  bool add(unsigned char a, unsigned char b);
+
+  /**
+   * @brief 解析混淆表并替换当前内容
+   * 格式为逗号分隔的若干对字符，如 "O0,I1,S5,B8"
+   *
+   * @param spec 混淆表
+   * @return 解析成功返回true；失败时表内容不变
+   */
+  bool parse(std::string_view spec);
+
+  /// 字节 c 可以替换成的字节
+  std::string_view substitutes(unsigned char c) const {
+    return std::string_view(subs_[c], count_[c]);
+  }
+
+private:
+  char subs_[256][kMaxSubstitutes];
+  std::uint8_t count_[256];
+};
+
+/**
+ * @brief 一个近似匹配
+ */
+struct FuzzyMatch {
+  Match match;                          ///< 匹配的位置、规则和年份
+  char corrected[Code::kCapacity] = {}; ///< 替换后的编码
+  std::size_t cost = 0;                 ///< 替换的字符数
+
+  bool found() const { return match.found(); }
+  explicit operator bool() const { return found(); }
+
+  /// 替换后的编码，符合规则
+  std::string_view correction() const {
+    return std::string_view(corrected, found() ? match.length : 0);
+  }
+};
+
+/**
+ * @brief 允许至多 k 处替换的近似扫描器
+ * 构造后只读，可以在多个线程中同时使用
+ */
+class FuzzyScanner {
+public:
+  /// 一个扫描器最多包含的规则数
+  static constexpr std::size_t kMaxRules = 8;
+  /// 允许的最多替换数
+  static constexpr std::size_t kMaxErrors = 3;
+
+  /**
+   * @brief 构造扫描器
+   * @param rules 规则数组，按优先级排列
+   * @param count 规则个数，超出 kMaxRules 的部分忽略
+   * @param years 年份集合；年份本身也可以被替换
+   * @param table 混淆表
+   * @param maxErrors 允许的最多替换数，超出 kMaxErrors 时按 kMaxErrors
+   */
+  FuzzyScanner(const RuleId *rules, std::size_t count, const YearSet &years,
+               const ConfusionTable &table, std::size_t maxErrors);
+
+  /**
+   * @brief 一趟扫描找出输入中所有替换数不超过 k 的匹配，包括互相重叠的
+   * 结果按偏移从小到大排列，同一偏移按规则顺序排列；每个匹配的替换数
+   * 都是该窗口所需的最少替换数
+   *
+   * @param input 输入
+   * @param out 结果追加到这里
+   * @return 找到的匹配个数
+   */
+  std::size_t findAll(std::string_view input,
+                      std::vector<FuzzyMatch> &out) const;
+
+  /**
+   * @brief 从输入中提取一个近似匹配
+   * 排在最前的规则优先，同一规则替换数少的优先，再按偏移。
+   * 规则为 {Code11, Code8}、k 为0时与 extractValid 相同
+   */
+  FuzzyMatch extract(std::string_view input) const;
+
+  /**
+   * @brief 整条验证：按规则顺序取第一条替换后整体符合的规则
+   * 同一条规则取替换数最少的改法
+   */
+  FuzzyMatch validate(std::string_view record) const;
+
+  std::size_t maxErrors() const { return maxErrors_; }
+
+private:
+  /**
+   * @brief 按混淆表把从 window 开始的窗口改成符合规则 r 的编码
+   * @return 替换数不超过 k 时返回true，结果写入 out
+   */
+  bool correct(const char *window, std::size_t r, std::size_t offset,
+               FuzzyMatch &out) const;
+
+  std::vector<RuleId> rules_;
+  std::vector<FixedMatcher> matchers_;
+  YearSet years_;
+  ConfusionTable table_;
+  std::size_t maxErrors_;
+  std::size_t words_ = 0;
+  std::vector<std::uint64_t> exactMasks_; ///< 256 × words_，按原字节前进
+  std::vector<std::uint64_t> substMasks_; ///< 256 × words_，只能替换后前进
+  std::vector<std::uint64_t> startMask_;  ///< 各规则第0位
+  std::vector<std::size_t> finalBit_;     ///< 各规则最后一位的状态位
+};
+
+} // namespace strreg
+
+#endif // STRREG_FUZZY_H
@@ -0,0 +1,311 @@
+/**
+ * @file mapped_scan.cpp
+ * @brief 基于内存映射的大文件扫描模式的实现
+ */
+
+#include "mapped_scan.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "automaton.h"
+#include "metrics.h"
+#include "window_scanner.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define STRREG_HAVE_MMAP 1
+#endif
+
+namespace strreg {
+
+MappedFile::~MappedFile() { close(); }
+
+#ifdef STRREG_HAVE_MMAP
+
+bool MappedFile::open(const std::string &path) {
+  close();
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    error_ = std::strerror(errno);
+    return false;
+  }
+  struct stat info;
+  if (::fstat(fd, &info) != 0) {
+    error_ = std::strerror(errno);
+    ::close(fd);
+    return false;
+  }
+  size_ = static_cast<std::size_t>(info.st_size);
+  if (size_ > 0) {
+    void *addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      error_ = std::strerror(errno);
+      size_ = 0;
+      ::close(fd);
+      return false;
+    }
+    // 扫描是顺序的，提示内核加大预读
+    ::madvise(addr, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char *>(addr);
+    mapped_ = true;
+  }
+  // 映射建立后即可关闭文件描述符
+  ::close(fd);
+  return true;
+}
+
+void MappedFile::close() {
+  if (mapped_) {
+    ::munmap(const_cast<char *>(data_), size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+  mapped_ = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string &path) {
+  close();
+  std::FILE *file = std::fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    error_ = std::strerror(errno);
+    return false;
+  }
+  std::vector<char> content;
+  char block[1 << 16];
+  std::size_t count;
+  while ((count = std::fread(block, 1, sizeof(block), file)) > 0) {
+    content.insert(content.end(), block, block + count);
+  }
+  std::fclose(file);
+  size_ = content.size();
+  if (size_ > 0) {
+    char *copy = new char[size_];
+    std::memcpy(copy, content.data(), size_);
+    data_ = copy;
+  }
+  return true;
+}
+
+void MappedFile::close() {
+  delete[] data_;
+  data_ = nullptr;
+  size_ = 0;
+}
+
+#endif
+
+namespace {
+
+/**
+ * @brief 把一个匹配格式化为一行：偏移\\t匹配\\t规则
+ */
+void formatHit(std::string &out, std::size_t offset, const char *code,
+               std::size_t length, std::string_view rule) {
+  char digits[24];
+  std::to_chars_result result =
+      std::to_chars(digits, digits + sizeof(digits), offset);
+  out.append(digits, result.ptr);
+  out.push_back('\t');
+  out.append(code, length);
+  out.push_back('\t');
+  out.append(rule.data(), rule.size());
+  out.push_back('\n');
+}
+
+/**
+ * @brief 参与扫描的规则：扫描器及每条规则的名称和年份槽位置
+ */
+struct ScanTarget {
+  const WindowScanner *scanner = nullptr;
+  std::vector<std::string_view> names;
+  std::vector<std::size_t> yearPos; ///< RuleSpec::npos 表示规则不含年份槽
+  const YearSet *years = nullptr;
+  DedupSink *sink = nullptr;        ///< 非空时命中交给去重汇总
+  std::vector<std::size_t> sinkRule; ///< 各规则在汇总中的序号
+};
+
+/**
+ * @brief 扫描映射区中起点落在 [begin, end) 内的全部匹配，结果追加到 out
+ * 实际扫描到 end + 重叠字节数为止，使跨越 end 的匹配也能找到
+ */
+void scanRange(const ScanTarget &target, const MappedFile &file,
+               std::size_t begin, std::size_t end, std::string &out) {
+  const WindowScanner &scanner = *target.scanner;
+  std::size_t overlap = scanner.maxLength() - 1;
+  std::size_t stop = std::min(file.size(), end + overlap);
+  const char *base = file.data() + begin;
+  STRREG_COUNT(BytesScanned, end - begin);
+  scanWindows(scanner, base, stop - begin,
+              [&](std::size_t r, std::size_t offset) {
+                if (begin + offset >= end) {
+                  // 起点属于下一段，由下一段负责报告
+                  return false;
+                }
+                std::size_t yearPos = target.yearPos[r];
+                if (yearPos != RuleSpec::npos &&
+                    target.years->indexOf(base + offset + yearPos) ==
+                        YearSet::npos) {
+                  return true;
+                }
+                if (target.sink != nullptr) {
+                  target.sink->add(target.sinkRule[r], base + offset,
+                                   begin + offset);
+                } else {
+                  formatHit(out, begin + offset, base + offset,
+                            scanner.matcher(r).length(), target.names[r]);
+                }
+                return true;
+              });
+}
+
+/**
+ * @brief 把映射区切成固定大小的段，工作线程按段扫描，写出线程按段的顺序输出
+ */
+class RangeScheduler {
+public:
+  RangeScheduler(const ScanTarget &target, const MappedFile &file,
+                 std::size_t rangeSize, std::size_t threads)
+      : target_(target), file_(file), rangeSize_(rangeSize),
+        threads_(threads),
+        total_((file.size() + rangeSize - 1) / rangeSize),
+        // 同时在途的段数有上限，避免输出在内存中无限堆积
+        slots_(threads * 4), done_(threads * 4, false) {}
+
+  void run() {
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < threads_; ++i) {
+      workers.emplace_back([this] { workLoop(); });
+    }
+    writeLoop();
+    for (std::thread &worker : workers) {
+      worker.join();
+    }
+  }
+
+private:
+  void workLoop() {
+    for (;;) {
+      std::size_t index;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        slotFree_.wait(lock, [this] {
+          return next_ >= total_ || next_ < written_ + slots_.size();
+        });
+        if (next_ >= total_) {
+          return;
+        }
+        index = next_++;
+      }
+
+      std::string &out = slots_[index % slots_.size()];
+      out.clear();
+      std::size_t begin = index * rangeSize_;
+      std::size_t end = std::min(file_.size(), begin + rangeSize_);
+      scanRange(target_, file_, begin, end, out);
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_[index % slots_.size()] = true;
+      slotDone_.notify_one();
+    }
+  }
+
+  void writeLoop() {
+    for (std::size_t index = 0; index < total_; ++index) {
+      std::size_t slot = index % slots_.size();
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        slotDone_.wait(lock, [&] { return done_[slot]; });
+      }
+      std::fwrite(slots_[slot].data(), 1, slots_[slot].size(), stdout);
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_[slot] = false;
+      ++written_;
+      slotFree_.notify_all();
+    }
+    std::fflush(stdout);
+  }
+
+  const ScanTarget &target_;
+  const MappedFile &file_;
+  std::size_t rangeSize_;
+  std::size_t threads_;
+  std::size_t total_;
+
+  std::mutex mutex_;
+  std::condition_variable slotFree_;
+  std::condition_variable slotDone_;
+  std::vector<std::string> slots_;
+  std::vector<bool> done_;
+  std::size_t next_ = 0;
+  std::size_t written_ = 0;
+};
+
+} // namespace
+
+int runMappedScan(const BatchOptions &options, std::size_t threads) {
+  if (options.input == "-") {
+    std::fprintf(stderr, "错误：--mmap 需要用 --input= 指定输入文件\n");
+    return 1;
+  }
+
+  MappedFile file;
+  if (!file.open(options.input)) {
+    std::fprintf(stderr, "错误：无法映射输入文件 %s：%s\n",
+                 options.input.c_str(), file.error().c_str());
+    return 1;
+  }
+
+  ScanTarget target;
+  target.years = &options.years;
+  target.sink = options.sink;
+  if (options.rules != nullptr) {
+    target.scanner = &options.rules->scanner(options.years);
+    for (std::size_t r = 0; r < options.rules->size(); ++r) {
+      target.names.push_back(options.rules->rule(r).name);
+      target.yearPos.push_back(options.rules->rule(r).yearPos);
+      target.sinkRule.push_back(r);
+    }
+  } else {
+    std::size_t count;
+    const RuleId *rules = familyRules(options.family, count);
+    target.scanner = &getWindowScanner(rules, count, options.years);
+    for (std::size_t r = 0; r < count; ++r) {
+      target.names.push_back(ruleName(rules[r]));
+      target.yearPos.push_back(0);
+      target.sinkRule.push_back(static_cast<std::size_t>(rules[r]));
+    }
+  }
+
+  if (threads > 1 && file.size() > options.chunkSize) {
+    RangeScheduler scheduler(target, file, options.chunkSize, threads);
+    scheduler.run();
+  } else {
+    // 单线程时同样按段扫描，输出占用的内存不随文件大小增长
+    std::string out;
+    for (std::size_t begin = 0; begin < file.size();
+         begin += options.chunkSize) {
+      out.clear();
+      scanRange(target, file, begin,
+                std::min(file.size(), begin + options.chunkSize), out);
+      std::fwrite(out.data(), 1, out.size(), stdout);
+    }
+    std::fflush(stdout);
+  }
+  return 0;
+}
+
+} // namespace strreg
@@ -0,0 +1,65 @@
+/**
+ * @file mapped_scan.h
+ * @brief 基于内存映射的大文件扫描模式
+ *
+ * 把整个文件映射到内存后直接在映射区上扫描内嵌的编码，不经过 iostream，
+ * 也不复制到 std::string。映射区被切成若干段交给工作线程，相邻段之间
+ * 重叠（最长规则长度 - 1）个字节，跨越段边界的匹配不会丢失，也不会重复报告。
+ */
+
+#ifndef STRREG_MAPPED_SCAN_H
+#define STRREG_MAPPED_SCAN_H
+
+#include <cstddef>
+#include <string>
+
+#include "batch.h"
+
+namespace strreg {
+
+/**
+ * @brief 只读映射整个文件；不支持 mmap 的平台上退回为整块读入内存
+ */
+class MappedFile {
+public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  /**
+   * @brief 打开并映射文件
+   * @param path 文件路径
+   * @return 成功返回true；失败时 error() 给出原因
+   */
+  bool open(const std::string &path);
+
+  const char *data() const { return data_; }
+  std::size_t size() const { return size_; }
+  const std::string &error() const { return error_; }
+
+private:
+  void close();
+
+  const char *data_ = nullptr;
+  std::size_t size_ = 0;
+  bool mapped_ = false;
+  std::string error_;
+};
+
+/**
+ * @brief 扫描整个映射文件，按绝对字节偏移从小到大输出每个匹配
+ * 输出格式：偏移\\t匹配\\t规则。大端面规则族报告所有11位和8位匹配，
+ * 小端面规则族报告所有10位匹配，指定规则文件时报告其中每条规则的匹配
+ * （包括互相重叠的匹配）。
+ *
+ * @param options 批处理参数，input 为文件路径，chunkSize 为每段的字节数
+ * @param threads 工作线程数
+ * @return 进程退出码，0表示成功
+ */
+int runMappedScan(const BatchOptions &options, std::size_t threads);
+
+} // namespace strreg
+
+#endif // STRREG_MAPPED_SCAN_H
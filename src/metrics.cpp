@@ -0,0 +1,419 @@
+/**
+ * @file metrics.cpp
+ * @brief 计数器与耗时直方图的合并和输出
+ */
+
+#include "metrics.h"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "validator.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define STRREG_HAVE_SIGNAL_DUMP 1
+#include <csignal>
+#include <unistd.h>
+#endif
+
+namespace strreg {
+namespace metrics {
+
+namespace detail {
+
+thread_local Block *current = nullptr;
+
+} // namespace detail
+
+namespace {
+
+/**
+ * @brief 所有线程的计数块
+ * 线程退出时把计数并入 retired 后注销自己的块
+ */
+struct Registry {
+  std::mutex mutex;
+  std::vector<detail::Block *> live;
+  Snapshot retired;
+};
+
+Registry &registry() {
+  // 不析构：静态对象析构之后仍可能有线程退出或写出指标
+  static Registry *instance = new Registry();
+  return *instance;
+}
+
+void mergeInto(Snapshot &total, const detail::Block &block) {
+  for (std::size_t c = 0; c < kCounters; ++c) {
+    total.counters[c] += block.counters[c].load(std::memory_order_relaxed);
+  }
+  for (std::size_t l = 0; l < kLatencies; ++l) {
+    total.calls[l] += block.calls[l].load(std::memory_order_relaxed);
+    for (std::size_t b = 0; b < kBuckets; ++b) {
+      total.buckets[l][b] +=
+          block.buckets[l][b].load(std::memory_order_relaxed);
+    }
+    total.totalNs[l] += block.totalNs[l].load(std::memory_order_relaxed);
+  }
+}
+
+void clearBlock(detail::Block &block) {
+  for (std::atomic<std::uint64_t> &value : block.counters) {
+    value.store(0, std::memory_order_relaxed);
+  }
+  for (std::atomic<std::uint64_t> &value : block.calls) {
+    value.store(0, std::memory_order_relaxed);
+  }
+  for (auto &buckets : block.buckets) {
+    for (std::atomic<std::uint64_t> &value : buckets) {
+      value.store(0, std::memory_order_relaxed);
+    }
+  }
+  for (std::atomic<std::uint64_t> &value : block.totalNs) {
+    value.store(0, std::memory_order_relaxed);
+  }
+}
+
+/**
+ * @brief 线程本地的块的所有者，线程退出时注销
+ */
+struct Holder {
+  detail::Block block;
+
+  Holder() {
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.live.push_back(&block);
+  }
+
+  ~Holder() {
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    mergeInto(r.retired, block);
+    for (std::size_t i = 0; i < r.live.size(); ++i) {
+      if (r.live[i] == &block) {
+        r.live[i] = r.live.back();
+        r.live.pop_back();
+        break;
+      }
+    }
+    detail::current = nullptr;
+  }
+};
+
+std::size_t bucketOf(std::uint64_t ns) {
+  std::size_t bucket = 0;
+  while (ns != 0 && bucket + 1 < kBuckets) {
+    ns >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+/// 第 b 个桶的上界（纳秒）
+std::uint64_t bucketLimit(std::size_t bucket) {
+  return bucket == 0 ? 0 : (std::uint64_t(1) << bucket) - 1;
+}
+
+void appendFormat(std::string &out, const char *format, ...) {
+  char line[256];
+  va_list args;
+  va_start(args, format);
+  int length = std::vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+  if (length > 0) {
+    out.append(line, std::min<std::size_t>(length, sizeof(line) - 1));
+  }
+}
+
+double fallbackRate(const Snapshot &s) {
+  std::uint64_t calls = s.count(Counter::ExtractCalls);
+  return calls == 0 ? 0.0
+                    : static_cast<double>(s.count(Counter::ExtractFallback)) /
+                          static_cast<double>(calls);
+}
+
+std::string formatText(const Snapshot &s) {
+  std::string out = "strreg 指标\n";
+  for (std::size_t c = 0; c < kCounters; ++c) {
+    appendFormat(out, "  %-21s %llu\n", counterName(static_cast<Counter>(c)),
+                 static_cast<unsigned long long>(s.counters[c]));
+  }
+  appendFormat(out, "  %-21s %.4f\n", "extract_fallback_rate",
+               fallbackRate(s));
+  for (std::size_t l = 0; l < kLatencies; ++l) {
+    Latency latency = static_cast<Latency>(l);
+    std::uint64_t sampled = s.sampled(latency);
+    if (sampled == 0) {
+      continue;
+    }
+    appendFormat(out,
+                 "  latency.%-13s calls=%llu sampled=%llu mean=%.1fns "
+                 "p50<=%lluns p90<=%lluns p99<=%lluns\n",
+                 latencyName(latency),
+                 static_cast<unsigned long long>(s.calls[l]),
+                 static_cast<unsigned long long>(sampled),
+                 static_cast<double>(s.totalNs[l]) /
+                     static_cast<double>(sampled),
+                 static_cast<unsigned long long>(s.quantile(latency, 0.5)),
+                 static_cast<unsigned long long>(s.quantile(latency, 0.9)),
+                 static_cast<unsigned long long>(s.quantile(latency, 0.99)));
+  }
+  return out;
+}
+
+std::string formatJson(const Snapshot &s) {
+  std::string out = "{\"counters\":{";
+  for (std::size_t c = 0; c < kCounters; ++c) {
+    appendFormat(out, "%s\"%s\":%llu", c == 0 ? "" : ",",
+                 counterName(static_cast<Counter>(c)),
+                 static_cast<unsigned long long>(s.counters[c]));
+  }
+  appendFormat(out, "},\"extract_fallback_rate\":%.6f,\"latency\":{",
+               fallbackRate(s));
+  for (std::size_t l = 0; l < kLatencies; ++l) {
+    Latency latency = static_cast<Latency>(l);
+    appendFormat(out,
+                 "%s\"%s\":{\"calls\":%llu,\"sampled\":%llu,"
+                 "\"total_ns\":%llu,\"p50_ns\":%llu,\"p90_ns\":%llu,"
+                 "\"p99_ns\":%llu,\"buckets\":[",
+                 l == 0 ? "" : ",", latencyName(latency),
+                 static_cast<unsigned long long>(s.calls[l]),
+                 static_cast<unsigned long long>(s.sampled(latency)),
+                 static_cast<unsigned long long>(s.totalNs[l]),
+                 static_cast<unsigned long long>(s.quantile(latency, 0.5)),
+                 static_cast<unsigned long long>(s.quantile(latency, 0.9)),
+                 static_cast<unsigned long long>(s.quantile(latency, 0.99)));
+    for (std::size_t b = 0; b < kBuckets; ++b) {
+      appendFormat(out, "%s%llu", b == 0 ? "" : ",",
+                   static_cast<unsigned long long>(s.buckets[l][b]));
+    }
+    out += "]}";
+  }
+  out += "}}\n";
+  return out;
+}
+
+/// 退出和信号时写出的目标
+struct DumpTarget {
+  Format format = Format::Text;
+  std::FILE *file = stderr;
+};
+
+DumpTarget exitTarget;
+
+void writeSnapshot(const DumpTarget &target) {
+  std::string text = format(snapshot(), target.format);
+  std::fwrite(text.data(), 1, text.size(), target.file);
+  std::fflush(target.file);
+}
+
+void dumpAtExitHandler() { writeSnapshot(exitTarget); }
+
+#ifdef STRREG_HAVE_SIGNAL_DUMP
+
+int signalPipe[2] = {-1, -1};
+
+extern "C" void onDumpSignal(int) {
+  // 信号处理函数中只做异步信号安全的 write
+  char byte = 0;
+  ssize_t ignored = write(signalPipe[1], &byte, 1);
+  (void)ignored;
+}
+
+#endif
+
+} // namespace
+
+const char *counterName(Counter counter) {
+  switch (counter) {
+  case Counter::Records:
+    return "records";
+  case Counter::BytesScanned:
+    return "bytes_scanned";
+  case Counter::YearCandidates:
+    return "year_candidates";
+  case Counter::RuleChecks:
+    return "rule_checks";
+  case Counter::ExtractCalls:
+    return "extract_calls";
+  case Counter::ExtractFallback:
+    return "extract_fallback8";
+  case Counter::FragmentSteps:
+    return "fragment_steps";
+  case Counter::MatchesCode11:
+    return "matches.code11";
+  case Counter::MatchesCode8:
+    return "matches.code8";
+  case Counter::MatchesCode10:
+    return "matches.code10";
+  case Counter::MatchesRuleSet:
+    return "matches.rules";
+  case Counter::kCount:
+    break;
+  }
+  return "unknown";
+}
+
+const char *latencyName(Latency latency) {
+  switch (latency) {
+  case Latency::Validate:
+    return "validate";
+  case Latency::Extract:
+    return "extract";
+  case Latency::Find:
+    return "find";
+  case Latency::Fragments:
+    return "fragments";
+  case Latency::Record:
+    return "record";
+  case Latency::kCount:
+    break;
+  }
+  return "unknown";
+}
+
+Counter matchCounter(RuleId rule) {
+  switch (rule) {
+  case RuleId::Code11:
+    return Counter::MatchesCode11;
+  case RuleId::Code8:
+    return Counter::MatchesCode8;
+  case RuleId::Code10:
+    return Counter::MatchesCode10;
+  }
+  return Counter::MatchesRuleSet;
+}
+
+std::uint64_t Snapshot::sampled(Latency latency) const {
+  std::uint64_t total = 0;
+  for (std::uint64_t count : buckets[static_cast<std::size_t>(latency)]) {
+    total += count;
+  }
+  return total;
+}
+
+std::uint64_t Snapshot::quantile(Latency latency, double q) const {
+  std::uint64_t total = sampled(latency);
+  if (total == 0) {
+    return 0;
+  }
+  // 第 rank 个（从1开始）调用所在的桶
+  std::uint64_t rank =
+      static_cast<std::uint64_t>(q * static_cast<double>(total));
+  rank = std::max<std::uint64_t>(1, std::min(rank, total));
+  std::uint64_t seen = 0;
+  const std::uint64_t *counts = buckets[static_cast<std::size_t>(latency)];
+  for (std::size_t b = 0; b < kBuckets; ++b) {
+    seen += counts[b];
+    if (seen >= rank) {
+      return bucketLimit(b);
+    }
+  }
+  return bucketLimit(kBuckets - 1);
+}
+
+detail::Block &detail::attach() {
+  thread_local Holder holder;
+  current = &holder.block;
+  return holder.block;
+}
+
+void record(Latency latency, std::uint64_t ns) {
+  detail::Block &block = detail::local();
+  const std::size_t l = static_cast<std::size_t>(latency);
+  detail::bump(block.buckets[l][bucketOf(ns)], 1);
+  detail::bump(block.totalNs[l], ns);
+}
+
+Snapshot snapshot() {
+  Registry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  Snapshot total = r.retired;
+  for (const detail::Block *block : r.live) {
+    mergeInto(total, *block);
+  }
+  return total;
+}
+
+void reset() {
+  Registry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  r.retired = Snapshot();
+  for (detail::Block *block : r.live) {
+    clearBlock(*block);
+  }
+}
+
+std::string format(const Snapshot &snapshot, Format format) {
+  return format == Format::Json ? formatJson(snapshot) : formatText(snapshot);
+}
+
+void dumpAtExit(Format format, std::FILE *file) {
+  static std::once_flag registered;
+  exitTarget.format = format;
+  exitTarget.file = file;
+  std::call_once(registered, [] { std::atexit(dumpAtExitHandler); });
+}
+
+bool dumpOnSignal(int sig, Format format, std::FILE *file) {
+#ifdef STRREG_HAVE_SIGNAL_DUMP
+  static std::once_flag started;
+  static DumpTarget target;
+  target.format = format;
+  target.file = file;
+  bool ok = true;
+  std::call_once(started, [&] {
+    if (pipe(signalPipe) != 0) {
+      ok = false;
+      return;
+    }
+    // 后台线程等待信号处理函数写入的字节，每收到一个就写出一次
+    std::thread([] {
+      char byte;
+      while (read(signalPipe[0], &byte, 1) == 1) {
+        writeSnapshot(target);
+      }
+    }).detach();
+  });
+  if (!ok || signalPipe[1] < 0) {
+    return false;
+  }
+  struct sigaction action = {};
+  action.sa_handler = onDumpSignal;
+  sigemptyset(&action.sa_mask);
+  action.sa_flags = SA_RESTART;
+  return sigaction(sig, &action, nullptr) == 0;
+#else
+  (void)sig;
+  (void)format;
+  (void)file;
+  return false;
+#endif
+}
+
+bool parseArgument(const std::string &arg) {
+  Format format;
+  if (arg == "--metrics=text") {
+    format = Format::Text;
+  } else if (arg == "--metrics=json") {
+    format = Format::Json;
+  } else {
+    return false;
+  }
+  if (!enabled()) {
+    std::fprintf(stderr, "警告：构建时未开启 STRREG_METRICS，指标均为0\n");
+  }
+  dumpAtExit(format);
+#ifdef SIGUSR1
+  dumpOnSignal(SIGUSR1, format);
+#endif
+  return true;
+}
+
+} // namespace metrics
+} // namespace strreg
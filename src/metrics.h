@@ -0,0 +1,243 @@
+/**
+ * @file metrics.h
+ * @brief 验证、提取和片段搜索热路径上的计数器与耗时直方图
+ *
+ * 构建时开启 STRREG_METRICS（CMake 选项 -DSTRREG_METRICS=ON）后，
+ * STRREG_COUNT 和 STRREG_TIME 在调用处累加计数和单次调用耗时；关闭时两个宏
+ * 展开为空语句，参数不求值，热路径上没有任何开销。
+ *
+ * 每个线程写自己的计数块，不加锁也不用原子读改写；snapshot 按需合并全部线程
+ * （含已退出线程留下的计数）。调用次数精确统计，耗时每个线程每 kTimingSample
+ * 次调用取样一次，以免读时钟的开销超过被测的调用本身。
+ *
+ * 结果可以输出为文本或 JSON，在进程退出时或收到信号时写出。
+ */
+
+#ifndef STRREG_METRICS_H
+#define STRREG_METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#ifndef STRREG_METRICS
+#define STRREG_METRICS 0
+#endif
+
+namespace strreg {
+
+enum class RuleId;
+
+namespace metrics {
+
+/**
+ * @brief 计数器
+ */
+enum class Counter {
+  Records,         ///< 批处理处理的记录数
+  BytesScanned,    ///< 查找接口扫描的字节数
+  YearCandidates,  ///< 年份前缀相符的候选窗口数
+  RuleChecks,      ///< 整条规则的检查次数
+  ExtractCalls,    ///< extractValid 的调用次数
+  ExtractFallback, ///< extractValid 没有11位匹配、返回8位匹配的次数
+  FragmentSteps,   ///< 片段搜索中向拼接串追加一个片段的次数
+  MatchesCode11,   ///< code11 的匹配数
+  MatchesCode8,    ///< code8 的匹配数
+  MatchesCode10,   ///< code10 的匹配数
+  MatchesRuleSet,  ///< 规则文件中规则的匹配数
+  kCount
+};
+
+/**
+ * @brief 单次调用耗时的直方图
+ */
+enum class Latency {
+  Validate,  ///< validate
+  Extract,   ///< extractValid
+  Find,      ///< findFirst / findAll
+  Fragments, ///< findInFragments / extractFromFragments
+  Record,    ///< 批处理中的一条记录
+  kCount
+};
+
+const std::size_t kCounters = static_cast<std::size_t>(Counter::kCount);
+const std::size_t kLatencies = static_cast<std::size_t>(Latency::kCount);
+/// 直方图第 b 个桶统计耗时在 [2^(b-1), 2^b) 纳秒的调用，第0个桶为0纳秒
+const std::size_t kBuckets = 40;
+/// 每个线程对同一类调用每隔多少次计时一次
+const std::uint32_t kTimingSample = 16;
+
+/// 计数器名称，用于输出
+const char *counterName(Counter counter);
+
+/// 直方图名称，用于输出
+const char *latencyName(Latency latency);
+
+/// 规则对应的匹配计数器
+Counter matchCounter(RuleId rule);
+
+/**
+ * @brief 合并后的全部计数
+ */
+struct Snapshot {
+  std::uint64_t counters[kCounters] = {};
+  std::uint64_t calls[kLatencies] = {}; ///< 调用次数
+  /// 取样调用的耗时分布
+  std::uint64_t buckets[kLatencies][kBuckets] = {};
+  std::uint64_t totalNs[kLatencies] = {}; ///< 取样调用的总耗时
+
+  std::uint64_t count(Counter counter) const {
+    return counters[static_cast<std::size_t>(counter)];
+  }
+  /// 计了时的调用次数
+  std::uint64_t sampled(Latency latency) const;
+  /**
+   * @brief 取样调用耗时分位数的上界
+   * @param q 分位，0到1之间
+   * @return 第 q 分位所在桶的上界（纳秒），没有调用时为0
+   */
+  std::uint64_t quantile(Latency latency, double q) const;
+};
+
+/**
+ * @brief 合并所有线程的计数
+ */
+Snapshot snapshot();
+
+/**
+ * @brief 清零所有线程的计数
+ * 与其他线程的累加并发时，并发期间的少量计数可能丢失
+ */
+void reset();
+
+/**
+ * @brief 输出格式
+ */
+enum class Format {
+  Text, ///< 每行一项，便于阅读
+  Json  ///< 单个 JSON 对象，便于采集
+};
+
+/// 把快照格式化为文本或 JSON
+std::string format(const Snapshot &snapshot, Format format);
+
+/**
+ * @brief 进程退出时把指标写到 file
+ * 多次调用时以最后一次为准
+ */
+void dumpAtExit(Format format, std::FILE *file = stderr);
+
+/**
+ * @brief 收到信号 sig 时把指标写到 file，进程继续运行
+ * 信号处理函数只唤醒一个后台线程，格式化和写出都在该线程中进行
+ *
+ * @return 平台支持时返回true
+ */
+bool dumpOnSignal(int sig, Format format, std::FILE *file = stderr);
+
+/**
+ * @brief 解析 --metrics=text|json 参数：退出时以及收到 SIGUSR1 时写到标准错误
+ * @param arg 命令行参数
+ * @return 参数是合法的 --metrics= 时返回true
+ */
+bool parseArgument(const std::string &arg);
+
+/// 构建时是否开启了 STRREG_METRICS
+constexpr bool enabled() { return STRREG_METRICS != 0; }
+
+namespace detail {
+
+/**
+ * @brief 一个线程的计数块
+ * 只有所属线程写入，用原子变量只是为了让合并时的读取不构成数据竞争
+ */
+struct Block {
+  std::atomic<std::uint64_t> counters[kCounters] = {};
+  std::atomic<std::uint64_t> calls[kLatencies] = {};
+  std::atomic<std::uint64_t> buckets[kLatencies][kBuckets] = {};
+  std::atomic<std::uint64_t> totalNs[kLatencies] = {};
+  std::uint32_t countdown[kLatencies] = {}; ///< 距下一次取样的调用数
+};
+
+extern thread_local Block *current;
+
+/// 为当前线程创建并登记计数块
+Block &attach();
+
+inline Block &local() {
+  Block *block = current;
+  return block != nullptr ? *block : attach();
+}
+
+inline void bump(std::atomic<std::uint64_t> &value, std::uint64_t n) {
+  value.store(value.load(std::memory_order_relaxed) + n,
+              std::memory_order_relaxed);
+}
+
+} // namespace detail
+
+/// 累加计数器
+inline void add(Counter counter, std::uint64_t n = 1) {
+  detail::bump(detail::local().counters[static_cast<std::size_t>(counter)], n);
+}
+
+/// 记录一次取样调用的耗时
+void record(Latency latency, std::uint64_t ns);
+
+/**
+ * @brief 作用域计时器：累加调用次数，取样时记录从构造到析构的耗时
+ */
+class ScopedTimer {
+public:
+  explicit ScopedTimer(Latency latency) : latency_(latency) {
+    const std::size_t l = static_cast<std::size_t>(latency);
+    detail::Block &block = detail::local();
+    detail::bump(block.calls[l], 1);
+    if (block.countdown[l]-- == 0) {
+      block.countdown[l] = kTimingSample - 1;
+      sampled_ = true;
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+  ~ScopedTimer() {
+    if (!sampled_) {
+      return;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start_;
+    record(latency_,
+           static_cast<std::uint64_t>(
+               std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                   .count()));
+  }
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+  Latency latency_;
+  bool sampled_ = false;
+  std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace metrics
+} // namespace strreg
+
+#if STRREG_METRICS
+/// 计数器 counter（Counter 的枚举名）加 n
+#define STRREG_COUNT(counter, n)                                               \
+  ::strreg::metrics::add(::strreg::metrics::Counter::counter, (n))
+/// 累加 counter 为表达式的值（如 matchCounter(rule)）
+#define STRREG_COUNT_AT(counter, n) ::strreg::metrics::add((counter), (n))
+/// 记录当前作用域的耗时，一个作用域中只能使用一次
+#define STRREG_TIME(latency)                                                   \
+  ::strreg::metrics::ScopedTimer strregMetricsTimer(                           \
+      ::strreg::metrics::Latency::latency)
+#else
+#define STRREG_COUNT(counter, n) ((void)0)
+#define STRREG_COUNT_AT(counter, n) ((void)0)
+#define STRREG_TIME(latency) ((void)0)
+#endif
+
+#endif // STRREG_METRICS_H
@@ -0,0 +1,212 @@
+/**
+ * @file pipeline.cpp
+ * @brief 多线程批处理流水线的实现
+ */
+
+#include "pipeline.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace strreg {
+
+namespace {
+
+/**
+ * @brief 流水线中传递的一块输入及其处理结果
+ */
+struct Chunk {
+  std::size_t seq = 0;     ///< 块序号，决定输出顺序
+  std::size_t firstId = 0; ///< 块中第一条记录的记录号
+  std::string data;        ///< 以整行结尾的输入（最后一块可以没有换行符）
+  std::string output;      ///< 格式化好的输出
+};
+
+class Pipeline {
+public:
+  Pipeline(std::FILE *file, const BatchOptions &options, std::size_t threads)
+      : file_(file), options_(options), threads_(threads) {
+    // 同时在途的块数有上限，读取过快时等待写出释放块
+    chunks_.resize(threads_ * 4);
+    for (std::unique_ptr<Chunk> &chunk : chunks_) {
+      chunk = std::make_unique<Chunk>();
+      free_.push_back(chunk.get());
+    }
+  }
+
+  void run() {
+    std::thread reader([this] { readLoop(); });
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < threads_; ++i) {
+      workers.emplace_back([this] { workLoop(); });
+    }
+    writeLoop();
+    reader.join();
+    for (std::thread &worker : workers) {
+      worker.join();
+    }
+  }
+
+private:
+  /// 读取线程：把输入切成以整行结尾的块
+  void readLoop() {
+    std::string carry;
+    std::size_t seq = 0;
+    std::size_t nextId = 1;
+    bool eof = false;
+    while (!eof) {
+      Chunk *chunk = takeFree();
+      chunk->data.swap(carry);
+      carry.clear();
+      eof = fill(chunk->data);
+
+      if (!eof) {
+        // 块尾不完整的一行留给下一块
+        std::size_t last = chunk->data.rfind('\n');
+        carry.assign(chunk->data, last + 1, std::string::npos);
+        chunk->data.resize(last + 1);
+      }
+      if (chunk->data.empty()) {
+        giveBack(chunk);
+        continue;
+      }
+
+      std::size_t records = static_cast<std::size_t>(
+          std::count(chunk->data.begin(), chunk->data.end(), '\n'));
+      if (chunk->data.back() != '\n') {
+        ++records;
+      }
+      chunk->seq = seq++;
+      chunk->firstId = nextId;
+      nextId += records;
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_.push_back(chunk);
+      workReady_.notify_one();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    total_ = seq;
+    finished_ = true;
+    workReady_.notify_all();
+    doneReady_.notify_all();
+  }
+
+  /**
+   * @brief 读满一块，且至少包含一个换行符（除非到达文件末尾）
+   * @return 到达文件末尾返回true
+   */
+  bool fill(std::string &data) {
+    std::size_t target = std::max(options_.chunkSize, data.size() + 1);
+    for (;;) {
+      std::size_t old = data.size();
+      data.resize(target);
+      std::size_t count = std::fread(&data[old], 1, target - old, file_);
+      data.resize(old + count);
+      if (count == 0) {
+        return true;
+      }
+      if (data.size() == target) {
+        if (data.find('\n') != std::string::npos) {
+          return false;
+        }
+        // 一行比块还长，扩大这一块
+        target *= 2;
+      }
+    }
+  }
+
+  /// 工作线程：领取块、逐条处理并格式化输出
+  void workLoop() {
+    for (;;) {
+      Chunk *chunk = nullptr;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        workReady_.wait(lock, [this] { return !pending_.empty() || finished_; });
+        if (pending_.empty()) {
+          return;
+        }
+        chunk = pending_.front();
+        pending_.pop_front();
+      }
+
+      chunk->output.clear();
+      std::size_t id = chunk->firstId;
+      forEachRecord(chunk->data, [&](std::string_view record) {
+        processAndFormat(chunk->output, id++, record, options_);
+      });
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_[chunk->seq] = chunk;
+      doneReady_.notify_one();
+    }
+  }
+
+  /// 写出线程：严格按块序号输出
+  void writeLoop() {
+    for (std::size_t next = 0;; ++next) {
+      Chunk *chunk = nullptr;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        doneReady_.wait(lock, [&] {
+          return done_.count(next) != 0 || (finished_ && next >= total_);
+        });
+        auto it = done_.find(next);
+        if (it == done_.end()) {
+          break;
+        }
+        chunk = it->second;
+        done_.erase(it);
+      }
+      std::fwrite(chunk->output.data(), 1, chunk->output.size(), stdout);
+      giveBack(chunk);
+    }
+    std::fflush(stdout);
+  }
+
+  Chunk *takeFree() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    freeReady_.wait(lock, [this] { return !free_.empty(); });
+    Chunk *chunk = free_.back();
+    free_.pop_back();
+    return chunk;
+  }
+
+  void giveBack(Chunk *chunk) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(chunk);
+    freeReady_.notify_one();
+  }
+
+  std::FILE *file_;
+  const BatchOptions &options_;
+  std::size_t threads_;
+
+  std::vector<std::unique_ptr<Chunk>> chunks_;
+  std::mutex mutex_;
+  std::condition_variable workReady_;
+  std::condition_variable doneReady_;
+  std::condition_variable freeReady_;
+  std::vector<Chunk *> free_;
+  std::deque<Chunk *> pending_;
+  std::map<std::size_t, Chunk *> done_;
+  std::size_t total_ = 0;
+  bool finished_ = false;
+};
+
+} // namespace
+
+void runPipeline(std::FILE *file, const BatchOptions &options,
+                 std::size_t threads) {
+  Pipeline pipeline(file, options, threads);
+  pipeline.run();
+}
+
+} // namespace strreg
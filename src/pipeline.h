@@ -0,0 +1,32 @@
+/**
+ * @file pipeline.h
+ * @brief 多线程批处理流水线
+ *
+ * 读取线程把输入切成固定大小、以整行结尾的块，工作线程池按块领取并处理，
+ * 写出线程按块的顺序输出结果。同步只发生在块的粒度上，输出顺序与输入一致。
+ */
+
+#ifndef STRREG_PIPELINE_H
+#define STRREG_PIPELINE_H
+
+#include <cstddef>
+#include <cstdio>
+
+#include "batch.h"
+
+namespace strreg {
+
+/**
+ * @brief 用多个工作线程处理输入中的全部记录，结果按输入顺序写到标准输出
+ * 输出与单线程批处理完全相同
+ *
+ * @param file 已打开的输入文件
+ * @param options 批处理参数，使用其中的 chunkSize 作为块大小
+ * @param threads 工作线程数
+ */
+void runPipeline(std::FILE *file, const BatchOptions &options,
+                 std::size_t threads);
+
+} // namespace strreg
+
+#endif // STRREG_PIPELINE_H
@@ -0,0 +1,324 @@
+/**
+ * @file reference.cpp
+ * @brief 原始实现的副本（仅去掉错误输出），用作差分校验的基准
+ */
+
+#include "reference.h"
+
+#include <algorithm>
+#include <regex>
+
+namespace strreg {
+namespace reference {
+
+namespace {
+
+void generatePermutations(const std::vector<std::string> &fragments,
+                          std::vector<std::vector<std::string>> &result) {
+  // 如果只有一个元素，直接返回该元素组成的排列
+  if (fragments.size() <= 1) {
+    result.push_back(fragments);
+    return;
+  }
+
+  // 对于每个可能的第一个元素，生成剩余元素的所有排列
+  for (size_t i = 0; i < fragments.size(); ++i) {
+    // 创建一个不包含当前元素的新片段数组
+    std::vector<std::string> remaining;
+    for (size_t j = 0; j < fragments.size(); ++j) {
+      if (j != i) {
+        remaining.push_back(fragments[j]);
+      }
+    }
+
+    // 递归生成剩余元素的所有排列
+    std::vector<std::vector<std::string>> subPermutations;
+    generatePermutations(remaining, subPermutations);
+
+    // 将当前元素添加到每个子排列的开头
+    for (const auto &perm : subPermutations) {
+      std::vector<std::string> newPerm;
+      newPerm.push_back(fragments[i]);
+      newPerm.insert(newPerm.end(), perm.begin(), perm.end());
+      result.push_back(newPerm);
+    }
+  }
+}
+
+void generateCombinations(const std::vector<std::string> &fragments,
+                          std::string current, size_t index,
+                          std::vector<std::string> &results) {
+  // 将当前组合添加到结果中
+  if (!current.empty()) {
+    results.push_back(current);
+  }
+
+  // 已经处理完所有片段，返回
+  if (index >= fragments.size()) {
+    return;
+  }
+
+  // 递归生成组合：选择当前片段
+  generateCombinations(fragments, current + fragments[index], index + 1,
+                       results);
+
+  // 递归生成组合：不选择当前片段
+  generateCombinations(fragments, current, index + 1, results);
+}
+
+} // namespace
+
+bool validateString11(const std::string &str, const std::string &year) {
+  if (year.length() != 2) {
+    return false;
+  }
+
+  // 构建正则表达式
+  // ^ 表示开始，$ 表示结束
+  // 使用传入的year参数替代前两位
+  // [45679] 表示第3位只能是4、5、6、7或9
+  // [012] 表示第4位只能是0、1或2
+  // .{4} 表示第5-8位可以是任意字符
+  // [12345] 表示第9位只能是1、2、3、4或5
+  // [012] 表示第10位只能是0、1或2
+  // . 表示第11位可以是任意字符
+  std::string pattern_str = "^" + year + "[45679][012].{4}[12345][012].$";
+  std::regex pattern(pattern_str);
+
+  return std::regex_match(str, pattern);
+}
+
+bool validateString8(const std::string &str, const std::string &year) {
+  if (year.length() != 2) {
+    return false;
+  }
+
+  // 如果字符串长度不是8位，直接返回false
+  if (str.length() != 8) {
+    return false;
+  }
+
+  // 构建正则表达式
+  // ^ 表示开始，$ 表示结束
+  // 使用传入的year参数替代前两位
+  // [45679] 表示第3位只能是4、5、6、7或9
+  // [012] 表示第4位只能是0、1或2
+  // .{4} 表示第5-8位可以是任意字符
+  std::string pattern_str = "^" + year + "[45679][012].{4}$";
+  std::regex pattern(pattern_str);
+
+  return std::regex_match(str, pattern);
+}
+
+std::string extractValidString(const std::string &input,
+                               const std::string &year) {
+  if (year.length() != 2) {
+    return "null";
+  }
+
+  // 首先尝试提取符合11位规则的字符串
+
+  // 如果字符串长度小于11位，尝试8位规则
+  if (input.length() < 11) {
+    // 如果长度等于8位，则直接验证
+    if (input.length() == 8) {
+      return validateString8(input, year) ? input : "null";
+    }
+    // 如果长度大于8位但小于11位，尝试提取8位子串
+    else if (input.length() > 8) {
+      // 提取所有可能的8位子串并验证
+      for (size_t i = 0; i <= input.length() - 8; ++i) {
+        std::string substr = input.substr(i, 8);
+        if (substr.substr(0, 2) == year && validateString8(substr, year)) {
+          return substr;
+        }
+      }
+    }
+    // 如果什么都没找到，返回"null"
+    return "null";
+  }
+
+  // 如果字符串长度等于11位，则直接验证整个字符串
+  if (input.length() == 11) {
+    if (validateString11(input, year)) {
+      return input;
+    }
+    // 如果11位字符串不符合规则，尝试提取8位子串
+    for (size_t i = 0; i <= input.length() - 8; ++i) {
+      std::string substr = input.substr(i, 8);
+      if (substr.substr(0, 2) == year && validateString8(substr, year)) {
+        return substr;
+      }
+    }
+    return "null";
+  }
+
+  // 如果字符串长度大于11位，则先尝试查找符合11位条件的子串
+  // 遍历所有可能的11位子串并验证
+  for (size_t i = 0; i <= input.length() - 11; ++i) {
+    std::string substr = input.substr(i, 11);
+    // 检查子串的前两位是否匹配指定的年份
+    if (substr.substr(0, 2) == year) {
+      // 验证完整的子串
+      if (validateString11(substr, year)) {
+        return substr;
+      }
+    }
+  }
+
+  // 如果没有找到符合11位规则的子串，尝试查找符合8位规则的子串
+  for (size_t i = 0; i <= input.length() - 8; ++i) {
+    std::string substr = input.substr(i, 8);
+    // 检查子串的前两位是否匹配指定的年份
+    if (substr.substr(0, 2) == year) {
+      // 验证8位子串
+      if (validateString8(substr, year)) {
+        return substr;
+      }
+    }
+  }
+
+  return "null";
+}
+
+std::string findValidFromFragments(const std::vector<std::string> &fragments,
+                                   const std::string &year) {
+  if (year.length() != 2) {
+    return "null";
+  }
+
+  // 首先将所有片段合并成一个完整字符串
+  std::string combined = "";
+  for (const auto &fragment : fragments) {
+    combined += fragment;
+  }
+
+  // 使用extractValidString函数从合并后的字符串中提取有效子串
+  std::string result = extractValidString(combined, year);
+  if (result != "null") {
+    return result;
+  }
+
+  // 尝试不同的片段组合顺序
+  // 这里使用一个简单的方法：从每个可能的起始片段开始，尝试所有可能的组合
+  for (size_t start = 0; start < fragments.size(); ++start) {
+    combined = fragments[start];
+
+    // 创建一个临时数组，包含除起始片段外的所有片段
+    std::vector<std::string> remainingFragments;
+    for (size_t i = 0; i < fragments.size(); ++i) {
+      if (i != start) {
+        remainingFragments.push_back(fragments[i]);
+      }
+    }
+
+    // 递归尝试所有可能的排列组合
+    std::vector<std::vector<std::string>> permutations;
+    generatePermutations(remainingFragments, permutations);
+
+    for (const auto &perm : permutations) {
+      std::string testString = combined;
+      for (const auto &frag : perm) {
+        testString += frag;
+      }
+
+      // 检查当前组合是否包含有效字符串
+      std::string validResult = extractValidString(testString, year);
+      if (validResult != "null") {
+        return validResult;
+      }
+    }
+  }
+
+  return "null";
+}
+
+bool validateString10(const std::string &str, const std::string &year) {
+  // 检查字符串长度是否为10
+  if (str.length() != 10) {
+    return false;
+  }
+
+  // 构建正则表达式模式
+  // 前两位是指定年份，第3位是[45679]，第4位是[012]，第9位是[A-G]
+  std::string pattern = "^" + year + "[45679][012]....[A-G].$";
+
+  // 创建正则表达式对象
+  std::regex regex_pattern(pattern);
+
+  // 使用正则表达式匹配字符串
+  return std::regex_match(str, regex_pattern);
+}
+
+std::vector<std::string> extractValidStrings(const std::string &input,
+                                             const std::string &year) {
+  std::vector<std::string> results;
+
+  // 如果输入字符串长度小于10位，直接返回空列表
+  if (input.length() < 10) {
+    return results;
+  }
+
+  // 构建正则表达式模式，用于搜索符合条件的子串
+  std::string pattern = year + "[45679][012]....[A-G].";
+  std::regex regex_pattern(pattern);
+
+  // 在输入字符串中搜索所有匹配项
+  std::sregex_iterator it(input.begin(), input.end(), regex_pattern);
+  std::sregex_iterator end;
+
+  // 将每个匹配项添加到结果列表
+  while (it != end) {
+    results.push_back(it->str());
+    ++it;
+  }
+
+  return results;
+}
+
+std::vector<std::string>
+extractFromFragments(const std::vector<std::string> &fragments,
+                     const std::string &year) {
+  std::vector<std::string> results;
+
+  // 如果没有片段，直接返回空结果
+  if (fragments.empty()) {
+    return results;
+  }
+
+  // 生成所有可能的片段排列
+  std::vector<std::string> allPermutations = fragments;
+  std::sort(allPermutations.begin(), allPermutations.end());
+
+  std::vector<std::string> validResults;
+
+  // 对每种排列生成所有可能的组合
+  do {
+    // 生成这个排列的所有组合
+    std::vector<std::string> combinations;
+    generateCombinations(allPermutations, "", 0, combinations);
+
+    // 检查每个组合是否包含符合要求的子串
+    for (const auto &combination : combinations) {
+      // 从组合中提取符合要求的子串
+      std::vector<std::string> extracted =
+          extractValidStrings(combination, year);
+
+      // 将符合要求的子串添加到结果中
+      validResults.insert(validResults.end(), extracted.begin(),
+                          extracted.end());
+    }
+
+  } while (
+      std::next_permutation(allPermutations.begin(), allPermutations.end()));
+
+  // 去除重复的结果
+  std::sort(validResults.begin(), validResults.end());
+  validResults.erase(std::unique(validResults.begin(), validResults.end()),
+                     validResults.end());
+
+  return validResults;
+}
+
+} // namespace reference
+} // namespace strreg
@@ -0,0 +1,62 @@
+/**
+ * @file reference.h
+ * @brief 基于 std::regex 的原始实现，作为差分校验的基准
+ *
+ * 这些函数保留项目最初的写法：每次调用都重新构造正则表达式，片段搜索
+ * 枚举全部排列。它们很慢，但行为就是规则的定义；更快的引擎必须在每个输入上
+ * 与它们给出相同的结果。不要优化这里的代码。
+ */
+
+#ifndef STRREG_REFERENCE_H
+#define STRREG_REFERENCE_H
+
+#include <string>
+#include <vector>
+
+namespace strreg {
+namespace reference {
+
+/**
+ * @brief 原始的11位整串验证（daduanmian.cpp 的 validateString）
+ */
+bool validateString11(const std::string &str, const std::string &year);
+
+/**
+ * @brief 原始的8位整串验证（daduanmian.cpp 的 validateString8）
+ */
+bool validateString8(const std::string &str, const std::string &year);
+
+/**
+ * @brief 原始的10位整串验证（xiaoduanmian.cpp 的 validateString）
+ */
+bool validateString10(const std::string &str, const std::string &year);
+
+/**
+ * @brief 原始的11位/8位提取，未找到时返回 "null"
+ */
+std::string extractValidString(const std::string &input,
+                               const std::string &year);
+
+/**
+ * @brief 原始的片段排列搜索，未找到时返回 "null"
+ */
+std::string findValidFromFragments(const std::vector<std::string> &fragments,
+                                   const std::string &year);
+
+/**
+ * @brief 原始的10位提取：从左到右不重叠的正则搜索
+ */
+std::vector<std::string> extractValidStrings(const std::string &input,
+                                             const std::string &year);
+
+/**
+ * @brief 原始的10位片段搜索：全部排列的全部子集拼接，排序去重
+ */
+std::vector<std::string>
+extractFromFragments(const std::vector<std::string> &fragments,
+                     const std::string &year);
+
+} // namespace reference
+} // namespace strreg
+
+#endif // STRREG_REFERENCE_H
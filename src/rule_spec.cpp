@@ -0,0 +1,305 @@
+/**
+ * @file rule_spec.cpp
+ * @brief 声明式规则的解析与编译
+ */
+
+#include "rule_spec.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+
+namespace strreg {
+
+namespace {
+
+/// 为每个规则集合的每个版本分配不重复的编号，供线程本地缓存判断是否失效
+std::uint64_t nextGeneration() {
+  static std::atomic<std::uint64_t> counter(0);
+  return ++counter;
+}
+
+/**
+ * @brief 解析字符类 [...] 的内容，pattern[i] 指向 '[' 之后的第一个字符
+ * @return 成功时返回 ']' 之后的下标，失败时返回 npos
+ */
+std::size_t parseClass(std::string_view pattern, std::size_t i,
+                       bool allowed[256]) {
+  bool negate = false;
+  if (i < pattern.length() && pattern[i] == '^') {
+    negate = true;
+    ++i;
+  }
+  bool set[256] = {};
+  bool first = true;
+  while (i < pattern.length() && (pattern[i] != ']' || first)) {
+    first = false;
+    unsigned char lo = static_cast<unsigned char>(pattern[i]);
+    if (lo == '\\') {
+      if (++i == pattern.length()) {
+        return std::string_view::npos;
+      }
+      lo = static_cast<unsigned char>(pattern[i]);
+    }
+    ++i;
+    unsigned char hi = lo;
+    // a-b 区间；末尾的 - 按字面字符处理
+    if (i + 1 < pattern.length() && pattern[i] == '-' &&
+        pattern[i + 1] != ']') {
+      ++i;
+      hi = static_cast<unsigned char>(pattern[i]);
+      if (hi == '\\') {
+        if (++i == pattern.length()) {
+          return std::string_view::npos;
+        }
+        hi = static_cast<unsigned char>(pattern[i]);
+      }
+      ++i;
+      if (hi < lo) {
+        return std::string_view::npos;
+      }
+    }
+    for (unsigned c = lo; c <= hi; ++c) {
+      set[c] = true;
+    }
+  }
+  if (i == pattern.length()) {
+    return std::string_view::npos;
+  }
+  for (unsigned c = 0; c < 256; ++c) {
+    allowed[c] = set[c] != negate;
+  }
+  return i + 1;
+}
+
+bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+} // namespace
+
+FixedMatcher RuleSpec::compile(const YearSet &years) const {
+  FixedMatcher compiled = matcher;
+  if (yearPos != npos) {
+    for (std::size_t i = 0; i < years.size(); ++i) {
+      std::string_view year = years.year(i);
+      compiled.allowChar(yearPos, static_cast<unsigned char>(year[0]));
+      compiled.allowChar(yearPos + 1, static_cast<unsigned char>(year[1]));
+    }
+  }
+  return compiled;
+}
+
+bool parseRuleSpec(std::string_view name, std::string_view pattern,
+                   RuleSpec &spec, std::string &error) {
+  bool table[FixedMatcher::kMaxLength][256];
+  std::size_t length = 0;
+  std::size_t yearPos = RuleSpec::npos;
+  const std::string tooLong =
+      "规则长度超过" + std::to_string(FixedMatcher::kMaxLength) + "位";
+
+  std::size_t i = 0;
+  while (i < pattern.length()) {
+    char c = pattern[i];
+    if (c == 'Y') {
+      if (i + 1 >= pattern.length() || pattern[i + 1] != 'Y') {
+        error = "年份槽必须写作连续的 YY";
+        return false;
+      }
+      if (yearPos != RuleSpec::npos) {
+        error = "一条规则只能有一个年份槽";
+        return false;
+      }
+      if (length + 2 > FixedMatcher::kMaxLength) {
+        error = tooLong;
+        return false;
+      }
+      // 年份两位暂不允许任何字符，由 RuleSpec::compile 填入
+      yearPos = length;
+      std::fill(table[length], table[length] + 256, false);
+      std::fill(table[length + 1], table[length + 1] + 256, false);
+      length += 2;
+      i += 2;
+      continue;
+    }
+
+    if (length == FixedMatcher::kMaxLength) {
+      error = tooLong;
+      return false;
+    }
+    bool *allowed = table[length++];
+    std::fill(allowed, allowed + 256, false);
+    if (c == '.') {
+      std::fill(allowed, allowed + 256, true);
+      allowed['\n'] = false;
+      allowed['\r'] = false;
+      ++i;
+    } else if (c == '[') {
+      i = parseClass(pattern, i + 1, allowed);
+      if (i == std::string_view::npos) {
+        error = "字符类格式错误";
+        return false;
+      }
+    } else {
+      if (c == '\\') {
+        if (++i == pattern.length()) {
+          error = "模式不能以 \\ 结尾";
+          return false;
+        }
+        c = pattern[i];
+      }
+      allowed[static_cast<unsigned char>(c)] = true;
+      ++i;
+    }
+  }
+  if (length == 0) {
+    error = "模式为空";
+    return false;
+  }
+
+  spec.name.assign(name.data(), name.size());
+  spec.yearPos = yearPos;
+  spec.matcher = FixedMatcher(length);
+  for (std::size_t pos = 0; pos < length; ++pos) {
+    for (unsigned c = 0; c < 256; ++c) {
+      if (table[pos][c]) {
+        spec.matcher.allowChar(pos, static_cast<unsigned char>(c));
+      }
+    }
+  }
+  return true;
+}
+
+RuleSet::RuleSet() : generation_(nextGeneration()) {}
+
+bool RuleSet::parse(std::string_view text, std::string &error) {
+  std::vector<RuleSpec> parsed;
+  std::size_t lineNumber = 0;
+  while (!text.empty()) {
+    std::size_t newline = text.find('\n');
+    std::string_view line = text.substr(0, newline);
+    text = newline == std::string_view::npos ? std::string_view()
+                                             : text.substr(newline + 1);
+    ++lineNumber;
+
+    std::size_t begin = 0;
+    while (begin < line.length() && isSpace(line[begin])) {
+      ++begin;
+    }
+    if (begin == line.length() || line[begin] == '#') {
+      continue;
+    }
+    std::size_t nameEnd = begin;
+    while (nameEnd < line.length() && !isSpace(line[nameEnd])) {
+      ++nameEnd;
+    }
+    std::size_t patternBegin = nameEnd;
+    while (patternBegin < line.length() && isSpace(line[patternBegin])) {
+      ++patternBegin;
+    }
+    std::size_t patternEnd = line.length();
+    while (patternEnd > patternBegin && isSpace(line[patternEnd - 1])) {
+      --patternEnd;
+    }
+
+    const std::string where = "第" + std::to_string(lineNumber) + "行：";
+    std::string_view name = line.substr(begin, nameEnd - begin);
+    std::string_view pattern =
+        line.substr(patternBegin, patternEnd - patternBegin);
+    if (pattern.empty()) {
+      error = where + "缺少模式";
+      return false;
+    }
+    bool duplicate = find(name) != npos;
+    for (const RuleSpec &spec : parsed) {
+      duplicate = duplicate || spec.name == name;
+    }
+    if (duplicate) {
+      error = where + "规则名称重复：" + std::string(name);
+      return false;
+    }
+    if (rules_.size() + parsed.size() >= WindowScanner::kMaxRules) {
+      error = where + "规则数超过" + std::to_string(WindowScanner::kMaxRules) +
+              "条";
+      return false;
+    }
+    RuleSpec spec;
+    if (!parseRuleSpec(name, pattern, spec, error)) {
+      error = where + error;
+      return false;
+    }
+    parsed.push_back(std::move(spec));
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (RuleSpec &spec : parsed) {
+    rules_.push_back(std::move(spec));
+  }
+  // 规则变化后已编译的扫描器作废
+  scanners_.clear();
+  generation_ = nextGeneration();
+  return true;
+}
+
+bool RuleSet::load(const std::string &path, std::string &error) {
+  std::FILE *file = std::fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    error = "无法打开规则文件 " + path;
+    return false;
+  }
+  std::string text;
+  char block[4096];
+  std::size_t count;
+  while ((count = std::fread(block, 1, sizeof(block), file)) > 0) {
+    text.append(block, count);
+  }
+  std::fclose(file);
+  return parse(text, error);
+}
+
+std::size_t RuleSet::find(std::string_view name) const {
+  for (std::size_t i = 0; i < rules_.size(); ++i) {
+    if (rules_[i].name == name) {
+      return i;
+    }
+  }
+  return npos;
+}
+
+const WindowScanner &RuleSet::scanner(const YearSet &years) const {
+  // 线程本地记住上一次使用的扫描器，连续相同参数的调用无需加锁
+  thread_local std::uint64_t lastGeneration = 0;
+  thread_local const std::string *lastKey = nullptr;
+  thread_local const WindowScanner *last = nullptr;
+  if (lastGeneration == generation_ && *lastKey == years.key()) {
+    return *last;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = scanners_.find(years.key());
+  if (it == scanners_.end()) {
+    std::vector<FixedMatcher> matchers;
+    for (const RuleSpec &spec : rules_) {
+      matchers.push_back(spec.compile(years));
+    }
+    it = scanners_
+             .emplace(years.key(), std::make_unique<WindowScanner>(matchers))
+             .first;
+  }
+  lastGeneration = generation_;
+  lastKey = &it->first;
+  last = it->second.get();
+  return *last;
+}
+
+std::size_t RuleSet::validate(std::string_view str,
+                              const YearSet &years) const {
+  const WindowScanner &compiled = scanner(years);
+  for (std::size_t r = 0; r < rules_.size(); ++r) {
+    if (compiled.matcher(r).match(str.data(), str.length()) &&
+        yearOf(r, str.data(), years) != YearSet::npos) {
+      return r;
+    }
+  }
+  return npos;
+}
+
+} // namespace strreg
@@ -0,0 +1,165 @@
+/**
+ * @file rule_spec.h
+ * @brief 从文本加载的声明式规则
+ *
+ * 规则文件每行定义一条规则：名称和模式，以空白分隔；空行和以 # 开头的行被忽略。
+ * 模式逐位描述定长规则，每一位是以下之一：
+ * - YY：两位年份槽，一条规则最多一个，匹配时由年份集合决定
+ * - .：任意字符（与正则表达式相同，不包括 \n 和 \r）
+ * - [...]：字符类，支持区间 a-b 和开头的 ^ 取反，\ 转义下一个字符
+ * - \c：字符 c 本身（用于 Y . [ \ 等特殊字符）
+ * - 其他字符：该字符本身
+ *
+ * 例如内置的11位规则写作：
+ *   code11  YY[45679][012]....[12345][012].
+ *
+ * 加载时每条规则编译成 FixedMatcher，整个规则集合编译成一个 WindowScanner，
+ * 一趟扫描即可匹配全部规则。
+ */
+
+#ifndef STRREG_RULE_SPEC_H
+#define STRREG_RULE_SPEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "fixed_matcher.h"
+#include "automaton.h"
+#include "window_scanner.h"
+#include "years.h"
+
+namespace strreg {
+
+/**
+ * @brief 一条已解析的规则
+ */
+struct RuleSpec {
+  /// 表示规则不含年份槽
+  static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+  std::string name;
+  FixedMatcher matcher;       ///< 年份槽的两位留空，由 compile 填入
+  std::size_t yearPos = npos; ///< 年份槽的起始位置
+
+  std::size_t length() const { return matcher.length(); }
+
+  /**
+   * @brief 填入年份后得到可用的匹配器
+   * @param years 年份集合；多个年份时年份两位放宽为各年份字符的并集
+   * @return 编译好的匹配器
+   */
+  FixedMatcher compile(const YearSet &years) const;
+};
+
+/**
+ * @brief 解析一条规则的模式
+ * @param name 规则名称
+ * @param pattern 模式
+ * @param spec 解析结果写入的位置
+ * @param error 失败时写入原因
+ * @return 成功返回true
+ */
+bool parseRuleSpec(std::string_view name, std::string_view pattern,
+                   RuleSpec &spec, std::string &error);
+
+/**
+ * @brief 规则集合，最多 WindowScanner::kMaxRules 条规则
+ */
+class RuleSet {
+public:
+  /// 表示没有规则匹配
+  static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+  RuleSet();
+  RuleSet(const RuleSet &) = delete;
+  RuleSet &operator=(const RuleSet &) = delete;
+
+  /**
+   * @brief 解析规则文本，规则追加到集合末尾
+   * 不能与同一集合上的扫描并发调用
+   *
+   * @param text 规则文本
+   * @param error 失败时写入原因（含行号）
+   * @return 成功返回true；失败时集合不变
+   */
+  bool parse(std::string_view text, std::string &error);
+
+  /**
+   * @brief 从文件加载规则，规则追加到集合末尾
+   * @param path 文件路径
+   * @param error 失败时写入原因
+   * @return 成功返回true
+   */
+  bool load(const std::string &path, std::string &error);
+
+  std::size_t size() const { return rules_.size(); }
+  bool empty() const { return rules_.empty(); }
+  const RuleSpec &rule(std::size_t index) const { return rules_[index]; }
+
+  /// 按名称查找规则，找不到时返回 npos
+  std::size_t find(std::string_view name) const;
+
+  /**
+   * @brief 取得按年份集合编译的扫描器，结果缓存在集合内
+   * 回调中的规则序号即规则在集合中的下标
+   */
+  const WindowScanner &scanner(const YearSet &years) const;
+
+  /**
+   * @brief 一趟扫描找出所有规则的全部匹配
+   * 按偏移从小到大（同一偏移按规则顺序）回调
+   * bool fn(std::size_t rule, std::size_t offset, std::size_t year)，
+   * 其中 year 为命中的年份在集合中的下标（规则不含年份槽时为0），
+   * 回调返回false时停止扫描
+   */
+  template <class Fn>
+  void scan(std::string_view input, const YearSet &years, Fn fn) const;
+
+  /**
+   * @brief 按规则顺序找出第一条整体匹配 str 的规则
+   * @param str 需要验证的字符串
+   * @param years 年份集合
+   * @return 规则下标；没有规则匹配时返回 npos
+   */
+  std::size_t validate(std::string_view str, const YearSet &years) const;
+
+private:
+  /// 确认匹配的年份，返回年份下标，不在集合中时返回 YearSet::npos
+  std::size_t yearOf(std::size_t rule, const char *window,
+                     const YearSet &years) const {
+    std::size_t pos = rules_[rule].yearPos;
+    return pos == RuleSpec::npos ? 0 : years.indexOf(window + pos);
+  }
+
+  std::vector<RuleSpec> rules_;
+  std::uint64_t generation_; ///< 集合内容的版本编号，全进程唯一
+
+  mutable std::mutex mutex_;
+  mutable std::map<std::string, std::unique_ptr<WindowScanner>> scanners_;
+};
+
+template <class Fn>
+void RuleSet::scan(std::string_view input, const YearSet &years,
+                   Fn fn) const {
+  if (years.empty()) {
+    return;
+  }
+  scanWindows(scanner(years), input.data(), input.length(),
+              [&](std::size_t rule, std::size_t offset) {
+                std::size_t year = yearOf(rule, input.data() + offset, years);
+                if (year == YearSet::npos) {
+                  return true;
+                }
+                return fn(rule, offset, year);
+              });
+}
+
+} // namespace strreg
+
+#endif // STRREG_RULE_SPEC_H
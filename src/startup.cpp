@@ -0,0 +1,469 @@
+/**
+ * @file startup.cpp
+ * @brief 命令行程序的冷启动与端到端性能回归测试（strreg_startup）
+ *
+ * 调度器为每个作业启动一次 string_validator，启动和第一次调用的延迟（静态
+ * 初始化、iostream 初始化、编译第一个正则表达式）直接计入作业耗时。本程序
+ * 以子进程方式运行构建出的两个程序，在固定种子生成的合成语料上测量：
+ * - 总耗时：从启动子进程到子进程退出
+ * - 首个结果耗时：从启动子进程到标准输出出现第一个字节
+ * - 峰值常驻内存（getrusage 的 ru_maxrss）
+ * 每个负载重复运行若干次，报告中位数和最小值；给出基线文件时与基线比较，
+ * 中位数超出容差即视为回归并返回非零。PGO 的训练运行也使用这些负载。
+ *
+ * 用法：
+ *   strreg_startup --bin-dir=目录 [--corpus-dir=目录] [--repeat=N]
+ *                  [--filter=子串] [--format=table|csv] [--save=文件]
+ *                  [--baseline=文件] [--tolerance=0.25]
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+/**
+ * @brief 一个负载：要运行的程序、参数和标准输入
+ */
+struct Workload {
+  std::string name;
+  std::string program;           ///< bin 目录下的程序名
+  std::vector<std::string> args; ///< 不含程序名
+  std::string input;             ///< 作为标准输入的语料文件，空为 /dev/null
+};
+
+/**
+ * @brief 一次运行的测量结果
+ */
+struct Sample {
+  double totalMs = 0;
+  double firstMs = 0; ///< 没有输出时等于 totalMs
+  long rssKb = 0;
+  bool ok = false;
+};
+
+/**
+ * @brief 一个负载多次运行的汇总
+ */
+struct Summary {
+  double totalMs = 0; ///< 总耗时的中位数
+  double minTotalMs = 0;
+  double firstMs = 0; ///< 首个结果耗时的中位数
+  long rssKb = 0;     ///< 峰值常驻内存的最大值
+};
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+/**
+ * @brief 启动子进程运行一次负载，读完它的全部输出
+ */
+Sample runOnce(const std::string &binDir, const Workload &workload) {
+  Sample sample;
+  std::string path = binDir + "/" + workload.program;
+  std::vector<char *> argv;
+  argv.push_back(const_cast<char *>(path.c_str()));
+  for (const std::string &arg : workload.args) {
+    argv.push_back(const_cast<char *>(arg.c_str()));
+  }
+  argv.push_back(nullptr);
+
+  int out[2];
+  if (::pipe(out) != 0) {
+    return sample;
+  }
+  const auto start = std::chrono::steady_clock::now();
+  pid_t pid = ::fork();
+  if (pid < 0) {
+    ::close(out[0]);
+    ::close(out[1]);
+    return sample;
+  }
+  if (pid == 0) {
+    const char *input =
+        workload.input.empty() ? "/dev/null" : workload.input.c_str();
+    int in = ::open(input, O_RDONLY);
+    int null = ::open("/dev/null", O_WRONLY);
+    if (in < 0 || null < 0) {
+      ::_exit(127);
+    }
+    ::dup2(in, STDIN_FILENO);
+    ::dup2(out[1], STDOUT_FILENO);
+    ::dup2(null, STDERR_FILENO);
+    ::close(out[0]);
+    ::close(out[1]);
+    ::execv(path.c_str(), argv.data());
+    ::_exit(127);
+  }
+
+  ::close(out[1]);
+  char buffer[1 << 16];
+  bool first = true;
+  for (;;) {
+    ssize_t n = ::read(out[0], buffer, sizeof(buffer));
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      break;
+    }
+    if (first) {
+      sample.firstMs = elapsedMs(start);
+      first = false;
+    }
+  }
+  ::close(out[0]);
+
+  int status = 0;
+  struct rusage usage;
+  std::memset(&usage, 0, sizeof(usage));
+  while (::wait4(pid, &status, 0, &usage) < 0 && errno == EINTR) {
+  }
+  sample.totalMs = elapsedMs(start);
+  if (first) {
+    sample.firstMs = sample.totalMs;
+  }
+  sample.rssKb = usage.ru_maxrss;
+  sample.ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  return sample;
+}
+
+double median(std::vector<double> values) {
+  std::sort(values.begin(), values.end());
+  std::size_t n = values.size();
+  return n % 2 == 1 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+/**
+ * @brief 生成合成语料
+ * 背景字符不含 '5'，命中率完全由生成参数决定；同一种子总生成相同的文件
+ */
+class CorpusWriter {
+public:
+  explicit CorpusWriter(std::uint64_t seed) : rng_(seed) {}
+
+  std::string noise(std::size_t length) {
+    static const char kAlphabet[] =
+        "012346789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+    std::string text(length, ' ');
+    for (char &c : text) {
+      c = kAlphabet[rng_() % (sizeof(kAlphabet) - 1)];
+    }
+    return text;
+  }
+
+  /// 一个11位编码，或 small 为 true 时的10位（小端面）编码
+  std::string code(bool small) {
+    std::string text = "25";
+    text += pick("45679");
+    text += pick("012");
+    text += noise(4);
+    text += small ? pick("ABCDEFG") : pick("12345");
+    if (!small) {
+      text += pick("012");
+    }
+    text += noise(1);
+    return text;
+  }
+
+  /**
+   * @brief 写出 count 条记录，每条长 length，千分之 hitPermille 的记录嵌入
+   * 一个编码，大端面和小端面的编码各占一半
+   * 逐条写出，不在内存中拼出整个语料：子进程的 ru_maxrss 从 fork 时
+   * 本进程的常驻内存算起，本进程须保持很小
+   */
+  bool records(std::FILE *file, std::size_t count, std::size_t length,
+               unsigned hitPermille) {
+    for (std::size_t i = 0; i < count; ++i) {
+      std::string record = noise(length);
+      if (rng_() % 1000 < hitPermille) {
+        std::string c = code(i % 2 == 1);
+        record.replace(rng_() % (length - c.length() + 1), c.length(), c);
+      }
+      record += '\n';
+      if (std::fwrite(record.data(), 1, record.size(), file) != record.size()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  char pick(const char *chars) {
+    return chars[rng_() % std::strlen(chars)];
+  }
+
+  std::mt19937_64 rng_;
+};
+
+bool writeFile(const std::string &path, const std::string &content) {
+  std::ofstream file(path, std::ios::binary);
+  file << content;
+  return static_cast<bool>(file);
+}
+
+/**
+ * @brief 在 dir 中生成全部语料，已存在的文件不重写
+ * @return 成功返回true
+ */
+bool prepareCorpus(const std::string &dir) {
+  ::mkdir(dir.c_str(), 0755);
+  struct Entry {
+    const char *name;
+    std::uint64_t seed;
+    std::size_t count;
+    std::size_t length;
+    unsigned hitPermille;
+  };
+  // one：单条记录，测首个结果；records：20万条短记录；blob：大块连续数据
+  static const Entry kEntries[] = {
+      {"empty.txt", 0, 0, 0, 0},
+      {"one.txt", 1, 1, 24, 1000},
+      {"records.txt", 2, 200000, 24, 300},
+      {"blob.txt", 3, 64, 1 << 17, 1000},
+  };
+  for (const Entry &entry : kEntries) {
+    std::string path = dir + "/" + entry.name;
+    struct stat st;
+    if (::stat(path.c_str(), &st) == 0) {
+      continue;
+    }
+    CorpusWriter writer(entry.seed);
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    bool ok = file != nullptr && writer.records(file, entry.count,
+                                                entry.length, entry.hitPermille);
+    if (file != nullptr && std::fclose(file) != 0) {
+      ok = false;
+    }
+    if (!ok) {
+      std::fprintf(stderr, "错误：无法写入语料 %s\n", path.c_str());
+      std::remove(path.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<Workload> workloads(const std::string &corpus) {
+  const std::string empty = corpus + "/empty.txt";
+  const std::string one = corpus + "/one.txt";
+  const std::string records = corpus + "/records.txt";
+  const std::string blob = corpus + "/blob.txt";
+  return {
+      // 冷启动：没有输入，只有进程启动、静态初始化和退出
+      {"startup/string_validator", "string_validator", {"--batch"}, empty},
+      {"startup/xiaoduanmian", "xiaoduanmian", {"--batch"}, empty},
+      // 首个结果：一条记录，包含第一次编译正则表达式或查找表
+      {"first/regex", "string_validator", {"--batch"}, one},
+      {"first/table", "string_validator", {"--batch", "--engine=table"}, one},
+      {"first/xiaoduanmian", "xiaoduanmian", {"--batch"}, one},
+      // 批处理
+      {"batch/extract", "string_validator", {"--batch", "--threads=1"},
+       records},
+      {"batch/extract/table",
+       "string_validator",
+       {"--batch", "--threads=1", "--engine=table"},
+       records},
+      {"batch/find-all/threads:4",
+       "string_validator",
+       {"--batch", "--mode=find-all", "--threads=4", "--engine=table"},
+       records},
+      {"batch/validate/xiaoduanmian",
+       "xiaoduanmian",
+       {"--batch", "--mode=validate", "--threads=1"},
+       records},
+      {"batch/mmap",
+       "string_validator",
+       {"--batch", "--mmap", "--threads=1", "--input=" + blob},
+       ""},
+      {"batch/stream/automaton",
+       "string_validator",
+       {"--batch", "--stream", "--engine=automaton"},
+       blob},
+      // 示例程序：验证、提取和片段组合搜索各若干次
+      {"fragments/string_validator", "string_validator", {}, ""},
+      {"fragments/xiaoduanmian", "xiaoduanmian", {}, ""},
+  };
+}
+
+/**
+ * @brief 读取 --save 写出的结果文件
+ */
+std::map<std::string, Summary> loadBaseline(const std::string &path) {
+  std::map<std::string, Summary> result;
+  std::ifstream file(path);
+  std::string line;
+  std::getline(file, line); // 表头
+  while (std::getline(file, line)) {
+    std::istringstream fields(line);
+    std::string name, total, minTotal, first, rss;
+    if (std::getline(fields, name, ',') && std::getline(fields, total, ',') &&
+        std::getline(fields, minTotal, ',') &&
+        std::getline(fields, first, ',') && std::getline(fields, rss, ',')) {
+      Summary s;
+      s.totalMs = std::atof(total.c_str());
+      s.minTotalMs = std::atof(minTotal.c_str());
+      s.firstMs = std::atof(first.c_str());
+      s.rssKb = std::atol(rss.c_str());
+      result[name] = s;
+    }
+  }
+  return result;
+}
+
+/**
+ * @brief 当前值是否超出基线的容差
+ * 另加0.5毫秒（内存为1MB）的绝对余量，避免毫秒以下的抖动误报
+ */
+bool regressed(double current, double base, double tolerance, double slack) {
+  return current > base * (1 + tolerance) + slack;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::string binDir = ".";
+  std::string corpus;
+  std::string filter;
+  std::string save;
+  std::string baseline;
+  double tolerance = 0.25;
+  std::size_t repeat = 5;
+  bool csv = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg.compare(0, 10, "--bin-dir=") == 0) {
+      binDir = arg.substr(10);
+    } else if (arg.compare(0, 13, "--corpus-dir=") == 0) {
+      corpus = arg.substr(13);
+    } else if (arg.compare(0, 9, "--filter=") == 0) {
+      filter = arg.substr(9);
+    } else if (arg.compare(0, 9, "--repeat=") == 0) {
+      repeat = std::max(1, std::atoi(arg.c_str() + 9));
+    } else if (arg.compare(0, 7, "--save=") == 0) {
+      save = arg.substr(7);
+    } else if (arg.compare(0, 11, "--baseline=") == 0) {
+      baseline = arg.substr(11);
+    } else if (arg.compare(0, 12, "--tolerance=") == 0) {
+      tolerance = std::atof(arg.c_str() + 12);
+    } else if (arg == "--format=csv") {
+      csv = true;
+    } else if (arg == "--format=table") {
+      csv = false;
+    } else {
+      std::fprintf(stderr, "未知参数：%s\n", arg.c_str());
+      return 1;
+    }
+  }
+  if (corpus.empty()) {
+    corpus = binDir + "/strreg_corpus";
+  }
+  if (!prepareCorpus(corpus)) {
+    return 1;
+  }
+
+  std::map<std::string, Summary> base;
+  if (!baseline.empty()) {
+    base = loadBaseline(baseline);
+    if (base.empty()) {
+      std::fprintf(stderr, "错误：无法读取基线文件 %s\n", baseline.c_str());
+      return 1;
+    }
+  }
+
+  const char *header = "workload,total_ms,min_total_ms,first_ms,peak_rss_kb";
+  std::string results = std::string(header) + "\n";
+  if (csv) {
+    std::printf("%s\n", header);
+  } else {
+    std::printf("%-34s %10s %10s %10s %10s\n", "Workload", "Total(ms)",
+                "Min(ms)", "First(ms)", "RSS(KB)");
+  }
+
+  int failures = 0;
+  for (const Workload &workload : workloads(corpus)) {
+    if (workload.name.find(filter) == std::string::npos) {
+      continue;
+    }
+    std::vector<double> totals;
+    std::vector<double> firsts;
+    Summary s;
+    // 先运行一次预热页缓存，不计入结果
+    runOnce(binDir, workload);
+    for (std::size_t r = 0; r < repeat; ++r) {
+      Sample sample = runOnce(binDir, workload);
+      if (!sample.ok) {
+        std::fprintf(stderr, "错误：负载 %s 运行失败\n",
+                     workload.name.c_str());
+        return 1;
+      }
+      totals.push_back(sample.totalMs);
+      firsts.push_back(sample.firstMs);
+      s.rssKb = std::max(s.rssKb, sample.rssKb);
+    }
+    s.totalMs = median(totals);
+    s.minTotalMs = *std::min_element(totals.begin(), totals.end());
+    s.firstMs = median(firsts);
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "%s,%.3f,%.3f,%.3f,%ld",
+                  workload.name.c_str(), s.totalMs, s.minTotalMs, s.firstMs,
+                  s.rssKb);
+    results += line;
+    results += '\n';
+    if (csv) {
+      std::printf("%s\n", line);
+    } else {
+      std::printf("%-34s %10.2f %10.2f %10.2f %10ld\n", workload.name.c_str(),
+                  s.totalMs, s.minTotalMs, s.firstMs, s.rssKb);
+    }
+    std::fflush(stdout);
+
+    auto it = base.find(workload.name);
+    if (it == base.end()) {
+      continue;
+    }
+    const Summary &b = it->second;
+    if (regressed(s.totalMs, b.totalMs, tolerance, 0.5) ||
+        regressed(s.firstMs, b.firstMs, tolerance, 0.5) ||
+        regressed(static_cast<double>(s.rssKb), static_cast<double>(b.rssKb),
+                  tolerance, 1024)) {
+      std::fprintf(stderr,
+                   "回归：%s 总耗时 %.2f→%.2fms，首个结果 %.2f→%.2fms，"
+                   "峰值内存 %ld→%ldKB\n",
+                   workload.name.c_str(), b.totalMs, s.totalMs, b.firstMs,
+                   s.firstMs, b.rssKb, s.rssKb);
+      ++failures;
+    }
+  }
+
+  if (!save.empty() && !writeFile(save, results)) {
+    std::fprintf(stderr, "错误：无法写入结果文件 %s\n", save.c_str());
+    return 1;
+  }
+  if (failures > 0) {
+    std::fprintf(stderr, "共 %d 个负载超出基线 %.0f%% 的容差\n", failures,
+                 tolerance * 100);
+    return 1;
+  }
+  return 0;
+}
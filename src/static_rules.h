@@ -0,0 +1,184 @@
+/**
+ * @file static_rules.h
+ * @brief 编译期展开的内置规则（仅头文件）
+ *
+ * 内置的11位、8位和10位规则除年份外在运行时从不变化。这里把每一位的字符类
+ * 写成 constexpr 常量，作为模板参数交给 staticMatch，编译器把整条规则展开成
+ * 不含循环和查表的直线代码：每一位只是一次减法、一次比较和一次常量移位。
+ * 年份仍是运行时参数，在前两位直接比较。
+ */
+
+#ifndef STRREG_STATIC_RULES_H
+#define STRREG_STATIC_RULES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "validator.h"
+
+namespace strreg {
+
+/**
+ * @brief 编译期字符类
+ * 表示 [lo, lo + 64) 范围内由 mask 选中的字节，negate 时取补集；
+ * year >= 0 时表示年份的第 year 位，由运行时参数决定
+ */
+struct StaticClass {
+  unsigned char lo = 0;
+  std::uint64_t mask = 0;
+  bool negate = false;
+  int year = -1;
+
+  /**
+   * @brief 判断字节 c 是否属于该字符类
+   * @param c 待判断的字节
+   * @param years 年份的两个字符
+   */
+  constexpr bool test(unsigned char c, const char *years) const {
+    if (year >= 0) {
+      return c == static_cast<unsigned char>(years[year]);
+    }
+    unsigned offset = static_cast<unsigned>(c) - lo;
+    bool in = offset < 64 && ((mask >> (offset & 63)) & 1u) != 0;
+    return in != negate;
+  }
+};
+
+/// 字符串 chars 中的任一字符（跨度不超过64）
+constexpr StaticClass staticOneOf(const char *chars) {
+  StaticClass cls;
+  cls.lo = 255;
+  for (const char *p = chars; *p != '\0'; ++p) {
+    if (static_cast<unsigned char>(*p) < cls.lo) {
+      cls.lo = static_cast<unsigned char>(*p);
+    }
+  }
+  for (const char *p = chars; *p != '\0'; ++p) {
+    cls.mask |= std::uint64_t(1) << (static_cast<unsigned char>(*p) - cls.lo);
+  }
+  return cls;
+}
+
+/// [lo, hi] 范围内的字符（跨度不超过64）
+constexpr StaticClass staticRange(char lo, char hi) {
+  StaticClass cls;
+  cls.lo = static_cast<unsigned char>(lo);
+  for (unsigned c = static_cast<unsigned char>(lo);
+       c <= static_cast<unsigned char>(hi); ++c) {
+    cls.mask |= std::uint64_t(1) << (c - cls.lo);
+  }
+  return cls;
+}
+
+/// 任意字符（与正则表达式的 . 相同，不包括 \n 和 \r）
+constexpr StaticClass staticAny() {
+  StaticClass cls = staticOneOf("\n\r");
+  cls.negate = true;
+  return cls;
+}
+
+/// 年份的第 index 位
+constexpr StaticClass staticYear(int index) {
+  StaticClass cls;
+  cls.year = index;
+  return cls;
+}
+
+/**
+ * @brief 长度为 N 的编译期规则
+ */
+template <std::size_t N> struct StaticRule {
+  static constexpr std::size_t length = N;
+  StaticClass pos[N];
+};
+
+/// 大端面11位规则：YY[45679][012]....[12345][012].
+inline constexpr StaticRule<11> kStaticCode11 = {
+    {staticYear(0), staticYear(1), staticOneOf("45679"), staticOneOf("012"),
+     staticAny(), staticAny(), staticAny(), staticAny(), staticOneOf("12345"),
+     staticOneOf("012"), staticAny()}};
+
+/// 大端面8位规则：YY[45679][012]....
+inline constexpr StaticRule<8> kStaticCode8 = {
+    {staticYear(0), staticYear(1), staticOneOf("45679"), staticOneOf("012"),
+     staticAny(), staticAny(), staticAny(), staticAny()}};
+
+/// 小端面10位规则：YY[45679][012]....[A-G].
+inline constexpr StaticRule<10> kStaticCode10 = {
+    {staticYear(0), staticYear(1), staticOneOf("45679"), staticOneOf("012"),
+     staticAny(), staticAny(), staticAny(), staticAny(),
+     staticRange('A', 'G'), staticAny()}};
+
+namespace detail {
+
+template <const auto &Rule, std::size_t... I>
+constexpr bool matchPositions(const char *str, const char *year,
+                              std::index_sequence<I...>) {
+  // 用 & 而不是 &&，各位的判断之间没有分支
+  return (true & ... &
+          Rule.pos[I].test(static_cast<unsigned char>(str[I]), year));
+}
+
+} // namespace detail
+
+/**
+ * @brief 用编译期规则验证从 str 开始的一个窗口
+ * 调用方需保证至少有规则长度个字节可读
+ *
+ * @tparam Rule 编译期规则（如 kStaticCode11）
+ * @param str 窗口起始地址
+ * @param year 两位年份的起始地址
+ */
+template <const auto &Rule>
+constexpr bool staticMatchAt(const char *str, const char *year) {
+  constexpr std::size_t length = std::decay_t<decltype(Rule)>::length;
+  return detail::matchPositions<Rule>(str, year,
+                                      std::make_index_sequence<length>());
+}
+
+/**
+ * @brief 用编译期规则验证整个字符串
+ * @tparam Rule 编译期规则
+ * @param str 需要验证的字符串
+ * @param year 两位年份
+ * @return 符合规则返回true；长度不符或年份不是两位时返回false
+ */
+template <const auto &Rule>
+constexpr bool staticMatch(std::string_view str, std::string_view year) {
+  return str.length() == std::decay_t<decltype(Rule)>::length &&
+         year.length() == 2 && staticMatchAt<Rule>(str.data(), year.data());
+}
+
+/**
+ * @brief 按规则编号分派到对应的编译期规则
+ * @param str 需要验证的字符串
+ * @param rule 规则
+ * @param year 两位年份
+ * @return 符合规则返回true
+ */
+inline bool staticValidate(std::string_view str, RuleId rule,
+                           std::string_view year) {
+  switch (rule) {
+  case RuleId::Code11:
+    return staticMatch<kStaticCode11>(str, year);
+  case RuleId::Code8:
+    return staticMatch<kStaticCode8>(str, year);
+  case RuleId::Code10:
+    return staticMatch<kStaticCode10>(str, year);
+  }
+  return false;
+}
+
+// 编译期自检：规则表在编译时就能求值
+static_assert(staticMatch<kStaticCode11>("25501234102", "25"), "code11");
+static_assert(!staticMatch<kStaticCode11>("25531234602", "25"), "code11");
+static_assert(staticMatch<kStaticCode8>("25702212", "25"), "code8");
+static_assert(staticMatch<kStaticCode10>("2550xyz0B1", "25"), "code10");
+static_assert(!staticMatch<kStaticCode10>("2550xyz\nB1", "25"), "code10");
+
+} // namespace strreg
+
+#endif // STRREG_STATIC_RULES_H
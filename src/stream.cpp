@@ -0,0 +1,151 @@
+/**
+ * @file stream.cpp
+ * @brief 流式匹配器的实现
+ */
+
+#include "stream.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+namespace strreg {
+
+StreamMatcher::StreamMatcher(const RuleId *rules, std::size_t count,
+                             const YearSet &years)
+    : rules_(rules, rules + count), years_(years) {
+  for (RuleId rule : rules_) {
+    context_ = std::max(context_, ruleLength(rule) - 1);
+  }
+  context_ = std::min(context_, kMaxContext);
+}
+
+std::size_t StreamMatcher::feed(std::string_view chunk,
+                                std::vector<Match> &out) {
+  const std::size_t before = out.size();
+
+  // 先在“上下文 + 新块开头”上找起点落在上下文中、终点落在新块中的匹配；
+  // 完全落在上下文中的匹配在之前的块中已经报告过
+  if (tailLength_ > 0 && !chunk.empty()) {
+    char joint[2 * kMaxContext];
+    const std::size_t head = std::min(chunk.length(), context_);
+    std::memcpy(joint, tail_, tailLength_);
+    std::memcpy(joint + tailLength_, chunk.data(), head);
+    const std::size_t first = out.size();
+    findAll(std::string_view(joint, tailLength_ + head), rules_.data(),
+            rules_.size(), years_, out);
+    std::size_t kept = first;
+    for (std::size_t i = first; i < out.size(); ++i) {
+      const Match &match = out[i];
+      if (match.offset < tailLength_ &&
+          match.offset + match.length > tailLength_) {
+        out[kept] = match;
+        out[kept].offset += position_ - tailLength_;
+        ++kept;
+      }
+    }
+    out.resize(kept);
+  }
+
+  // 再找完全落在新块中的匹配，原地扫描，不复制
+  const std::size_t first = out.size();
+  findAll(chunk, rules_.data(), rules_.size(), years_, out);
+  for (std::size_t i = first; i < out.size(); ++i) {
+    out[i].offset += position_;
+  }
+
+  // 保留已输入部分的最后 context_ 个字节
+  if (chunk.length() >= context_) {
+    std::memcpy(tail_, chunk.data() + chunk.length() - context_, context_);
+    tailLength_ = context_;
+  } else {
+    const std::size_t keep = std::min(tailLength_, context_ - chunk.length());
+    std::memmove(tail_, tail_ + tailLength_ - keep, keep);
+    std::memcpy(tail_ + keep, chunk.data(), chunk.length());
+    tailLength_ = keep + chunk.length();
+  }
+  position_ += chunk.length();
+  reported_ += out.size() - before;
+  return out.size() - before;
+}
+
+std::size_t StreamMatcher::finish() {
+  const std::size_t reported = reported_;
+  tailLength_ = 0;
+  position_ = 0;
+  reported_ = 0;
+  return reported;
+}
+
+int runStreamScan(const BatchOptions &options) {
+  if (options.rules != nullptr) {
+    std::fprintf(stderr, "错误：--stream 只支持内置规则\n");
+    return 1;
+  }
+  std::FILE *file = stdin;
+  if (options.input != "-") {
+    file = std::fopen(options.input.c_str(), "rb");
+    if (file == nullptr) {
+      std::fprintf(stderr, "错误：无法打开输入文件 %s\n",
+                   options.input.c_str());
+      return 1;
+    }
+  }
+
+  std::size_t count;
+  const RuleId *rules = familyRules(options.family, count);
+  StreamMatcher matcher(rules, count, options.years);
+
+  // 每读到一块就输出这一块中结束的匹配，格式与 --mmap 相同
+  std::vector<char> buffer(options.chunkSize);
+  std::vector<Match> matches;
+  std::string out;
+  std::size_t length;
+  while ((length = std::fread(buffer.data(), 1, buffer.size(), file)) > 0) {
+    // 跨越块边界的匹配，前半部分在上一块中，从匹配器保留的上下文中取回
+    char carried[StreamMatcher::kMaxContext];
+    const std::string_view tail = matcher.tail();
+    std::memcpy(carried, tail.data(), tail.length());
+    const std::size_t base = matcher.position();
+    const std::size_t carriedBase = base - tail.length();
+    const std::string_view chunk(buffer.data(), length);
+    matches.clear();
+    matcher.feed(chunk, matches);
+    out.clear();
+    for (const Match &match : matches) {
+      char code[FixedMatcher::kMaxLength];
+      if (match.offset >= base) {
+        std::memcpy(code, chunk.data() + (match.offset - base), match.length);
+      } else {
+        const std::size_t head = base - match.offset;
+        std::memcpy(code, carried + (match.offset - carriedBase), head);
+        std::memcpy(code + head, chunk.data(), match.length - head);
+      }
+      if (options.sink != nullptr) {
+        options.sink->add(static_cast<std::size_t>(match.rule), code,
+                          match.offset);
+        continue;
+      }
+      char digits[24];
+      std::to_chars_result result =
+          std::to_chars(digits, digits + sizeof(digits), match.offset);
+      out.append(digits, result.ptr);
+      out.push_back('\t');
+      out.append(code, match.length);
+      out.push_back('\t');
+      out.append(ruleName(match.rule));
+      out.push_back('\n');
+    }
+    std::fwrite(out.data(), 1, out.size(), stdout);
+  }
+  matcher.finish();
+  std::fflush(stdout);
+
+  if (file != stdin) {
+    std::fclose(file);
+  }
+  return 0;
+}
+
+} // namespace strreg
@@ -0,0 +1,99 @@
+/**
+ * @file stream.h
+ * @brief 按任意大小的块增量输入的流式匹配器
+ *
+ * 网络采集端收到的记录是分段到达的。流式匹配器不需要先把整个流拼起来：
+ * 每次 feed 一块，只在块之间保留（最长规则长度 - 1）个字节的上下文，
+ * 跨越块边界的匹配在读到它的最后一个字节时报告，偏移是在整个流中的偏移。
+ * 无论流有多长，匹配器占用的内存都是固定的。
+ */
+
+#ifndef STRREG_STREAM_H
+#define STRREG_STREAM_H
+
+#include <cstddef>
+#include <initializer_list>
+#include <string_view>
+#include <vector>
+
+#include "batch.h"
+#include "extract.h"
+#include "fixed_matcher.h"
+#include "years.h"
+
+namespace strreg {
+
+/**
+ * @brief 流式匹配器
+ * 对同一个流依次 feed 的全部结果，与对拼接后的整个流调用 findAll 找到的
+ * 匹配相同。每个匹配在读到它最后一个字节的那次 feed 中报告，不等待更长的
+ * 规则，因此跨块时顺序可能不同：同一起点的8位匹配可能先于11位匹配报告
+ */
+class StreamMatcher {
+public:
+  /// 块之间最多保留的字节数
+  static constexpr std::size_t kMaxContext = FixedMatcher::kMaxLength - 1;
+
+  /**
+   * @brief 构造匹配器
+   * @param rules 规则数组
+   * @param count 规则个数
+   * @param years 年份集合
+   */
+  StreamMatcher(const RuleId *rules, std::size_t count, const YearSet &years);
+
+  StreamMatcher(std::initializer_list<RuleId> rules, const YearSet &years)
+      : StreamMatcher(rules.begin(), rules.size(), years) {}
+
+  /**
+   * @brief 输入流的下一块
+   * 报告在这一块中结束的全部匹配，按偏移从小到大排列，同一偏移按规则顺序
+   *
+   * @param chunk 下一块，可以为任意长度（包括空块）
+   * @param out 结果追加到这里，Match::offset 为在整个流中的偏移
+   * @return 这一块报告的匹配个数
+   */
+  std::size_t feed(std::string_view chunk, std::vector<Match> &out);
+
+  /**
+   * @brief 结束当前的流，之后可以开始新的流
+   * 匹配都在读到最后一个字节时报告，结束时不会再有新的匹配
+   *
+   * @return 整个流报告的匹配个数
+   */
+  std::size_t finish();
+
+  /// 当前的流已输入的字节数
+  std::size_t position() const { return position_; }
+
+  /**
+   * @brief 已输入部分的最后若干字节（不超过最长规则长度 - 1）
+   * 调用方可以在下一次 feed 之前用它取回跨越块边界的匹配的前半部分
+   */
+  std::string_view tail() const {
+    return std::string_view(tail_, tailLength_);
+  }
+
+private:
+  std::vector<RuleId> rules_;
+  YearSet years_;
+  std::size_t context_ = 0;
+  char tail_[kMaxContext] = {}; ///< 已输入部分的最后 tailLength_ 个字节
+  std::size_t tailLength_ = 0;
+  std::size_t position_ = 0;
+  std::size_t reported_ = 0;
+};
+
+/**
+ * @brief 按块读取输入（文件或标准输入），报告其中内嵌的全部编码
+ * 每块 chunkSize 个字节，输出格式与 runMappedScan 相同：偏移\\t匹配\\t规则；
+ * 每读到一块就输出在这一块中结束的匹配
+ *
+ * @param options 批处理参数
+ * @return 进程退出码，0表示成功
+ */
+int runStreamScan(const BatchOptions &options);
+
+} // namespace strreg
+
+#endif // STRREG_STREAM_H
@@ -0,0 +1,89 @@
+/**
+ * @file strreg.cpp
+ * @brief 批量接口的实现
+ */
+
+#include "strreg.h"
+
+#include <algorithm>
+
+#include "automaton.h"
+#include "metrics.h"
+#include "window_scanner.h"
+
+namespace strreg {
+
+std::size_t validateBatch(const std::string_view *records, std::size_t count,
+                          const RuleId *rules, std::size_t ruleCount,
+                          const YearSet &years, Match *out) {
+  if (years.empty() || ruleCount == 0) {
+    std::fill(out, out + count, Match());
+    return 0;
+  }
+  // 年份两位已按集合放宽，整条匹配后再确认年份
+  const WindowScanner &scanner = getWindowScanner(rules, ruleCount, years);
+  std::size_t found = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    std::string_view record = records[i];
+    out[i] = Match();
+    for (std::size_t r = 0; r < scanner.ruleCount(); ++r) {
+      const FixedMatcher &matcher = scanner.matcher(r);
+      if (record.length() != matcher.length()) {
+        continue;
+      }
+      std::size_t year = years.indexOf(record.data());
+      if (year != YearSet::npos && matcher.matchAt(record.data())) {
+        out[i].offset = 0;
+        out[i].length = record.length();
+        out[i].rule = rules[r];
+        out[i].year = year;
+        STRREG_COUNT_AT(metrics::matchCounter(rules[r]), 1);
+        ++found;
+        break;
+      }
+    }
+  }
+  STRREG_COUNT(Records, count);
+  return found;
+}
+
+std::size_t extractBatch(const std::string_view *records, std::size_t count,
+                         const RuleId *rules, std::size_t ruleCount,
+                         const YearSet &years, Match *out) {
+  if (years.empty() || ruleCount == 0) {
+    std::fill(out, out + count, Match());
+    return 0;
+  }
+  const WindowScanner &scanner = getWindowScanner(rules, ruleCount, years);
+  std::size_t found = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    std::string_view record = records[i];
+    Match &best = out[i];
+    best = Match();
+    std::size_t bestRule = ruleCount;
+    // 回调按偏移递增，每条规则第一次出现即其最早的匹配；
+    // 只保留序号最小的规则，排在最前的规则出现后即可停止
+    scanWindows(scanner, record.data(), record.length(),
+                [&](std::size_t rule, std::size_t offset) {
+                  std::size_t year = years.indexOf(record.data() + offset);
+                  if (year == YearSet::npos || rule >= bestRule) {
+                    return true;
+                  }
+                  bestRule = rule;
+                  best.offset = offset;
+                  best.length = scanner.matcher(rule).length();
+                  best.rule = rules[rule];
+                  best.year = year;
+                  return rule != 0;
+                });
+    if (best) {
+      STRREG_COUNT_AT(metrics::matchCounter(best.rule), 1);
+      ++found;
+    }
+    STRREG_COUNT(BytesScanned, record.length());
+  }
+  STRREG_COUNT(Records, count);
+  return found;
+}
+
+} // namespace strreg
@@ -0,0 +1,81 @@
+/**
+ * @file strreg.h
+ * @brief strreg 库的公共头文件
+ *
+ * 库的使用者只需包含本文件：验证、提取、多年份、片段搜索和声明式规则的
+ * 接口都在 strreg 命名空间中，与两个示例程序里的 validateString 等同名
+ * 函数互不冲突。
+ *
+ * 本文件另外提供批量接口：一次调用处理一个 (地址, 长度) 记录数组，
+ * 扫描器、验证器和年份表只在每批开始时取一次，跨 FFI 调用时也只付一次
+ * 调用开销。C 语言接口见 strreg_c.h。
+ */
+
+#ifndef STRREG_STRREG_H
+#define STRREG_STRREG_H
+
+#include <cstddef>
+#include <initializer_list>
+#include <string_view>
+
+#include "extract.h"
+#include "fragments.h"
+#include "rule_spec.h"
+#include "validator.h"
+#include "years.h"
+
+namespace strreg {
+
+/**
+ * @brief 整条验证一批记录
+ * 每条记录按规则顺序找出第一条整体匹配的规则
+ *
+ * @param records 记录数组
+ * @param count 记录条数
+ * @param rules 规则数组，按优先级排列
+ * @param ruleCount 规则个数
+ * @param years 年份集合
+ * @param out 结果数组，至少 count 个元素；不符合时为未找到
+ * @return 符合规则的记录条数
+ */
+std::size_t validateBatch(const std::string_view *records, std::size_t count,
+                          const RuleId *rules, std::size_t ruleCount,
+                          const YearSet &years, Match *out);
+
+inline std::size_t validateBatch(const std::string_view *records,
+                                 std::size_t count,
+                                 std::initializer_list<RuleId> rules,
+                                 const YearSet &years, Match *out) {
+  return validateBatch(records, count, rules.begin(), rules.size(), years,
+                       out);
+}
+
+/**
+ * @brief 在一批记录中各提取一个匹配
+ * 每条记录返回排在最前的、在记录中出现过的规则的第一个匹配。
+ * 规则为 {Code11, Code8} 时与 extractValid 相同，为 {Code10} 时与
+ * findFirst 相同
+ *
+ * @param records 记录数组
+ * @param count 记录条数
+ * @param rules 规则数组，按优先级排列
+ * @param ruleCount 规则个数
+ * @param years 年份集合
+ * @param out 结果数组，至少 count 个元素；没有匹配时为未找到
+ * @return 找到匹配的记录条数
+ */
+std::size_t extractBatch(const std::string_view *records, std::size_t count,
+                         const RuleId *rules, std::size_t ruleCount,
+                         const YearSet &years, Match *out);
+
+inline std::size_t extractBatch(const std::string_view *records,
+                                std::size_t count,
+                                std::initializer_list<RuleId> rules,
+                                const YearSet &years, Match *out) {
+  return extractBatch(records, count, rules.begin(), rules.size(), years,
+                      out);
+}
+
+} // namespace strreg
+
+#endif // STRREG_STRREG_H
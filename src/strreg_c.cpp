@@ -0,0 +1,149 @@
+/**
+ * @file strreg_c.cpp
+ * @brief C 语言接口的实现
+ */
+
+#include "strreg_c.h"
+
+#include <algorithm>
+#include <memory>
+#include <string_view>
+
+#include "strreg.h"
+#include "window_scanner.h"
+
+struct strreg_years {
+  strreg::YearSet years;
+};
+
+namespace {
+
+/// 每次转换的记录条数，转换用的数组放在栈上
+const std::size_t kChunk = 256;
+
+using BatchFn = std::size_t (*)(const std::string_view *, std::size_t,
+                                const strreg::RuleId *, std::size_t,
+                                const strreg::YearSet &, strreg::Match *);
+
+bool toRules(const int *rules, std::size_t count, strreg::RuleId *out) {
+  if (rules == nullptr || count == 0 ||
+      count > strreg::WindowScanner::kMaxRules) {
+    return false;
+  }
+  for (std::size_t r = 0; r < count; ++r) {
+    switch (rules[r]) {
+    case STRREG_CODE11:
+      out[r] = strreg::RuleId::Code11;
+      break;
+    case STRREG_CODE8:
+      out[r] = strreg::RuleId::Code8;
+      break;
+    case STRREG_CODE10:
+      out[r] = strreg::RuleId::Code10;
+      break;
+    default:
+      return false;
+    }
+  }
+  return true;
+}
+
+int ruleNumber(strreg::RuleId rule) {
+  switch (rule) {
+  case strreg::RuleId::Code11:
+    return STRREG_CODE11;
+  case strreg::RuleId::Code8:
+    return STRREG_CODE8;
+  case strreg::RuleId::Code10:
+    return STRREG_CODE10;
+  }
+  return -1;
+}
+
+/**
+ * @brief 按块把 C 结构转换成 string_view 和 Match，再调用 C++ 批量接口
+ */
+long runBatch(BatchFn fn, const strreg_record *records, std::size_t count,
+              const int *rules, std::size_t ruleCount,
+              const strreg_years *years, strreg_match *out) {
+  strreg::RuleId ids[strreg::WindowScanner::kMaxRules];
+  if ((records == nullptr && count != 0) || (out == nullptr && count != 0) ||
+      years == nullptr || !toRules(rules, ruleCount, ids)) {
+    return -1;
+  }
+  try {
+    std::string_view views[kChunk];
+    strreg::Match matches[kChunk];
+    long found = 0;
+    for (std::size_t begin = 0; begin < count; begin += kChunk) {
+      std::size_t n = std::min(kChunk, count - begin);
+      for (std::size_t i = 0; i < n; ++i) {
+        const strreg_record &record = records[begin + i];
+        views[i] = record.data != nullptr
+                       ? std::string_view(record.data, record.length)
+                       : std::string_view();
+      }
+      found += static_cast<long>(
+          fn(views, n, ids, ruleCount, years->years, matches));
+      for (std::size_t i = 0; i < n; ++i) {
+        const strreg::Match &match = matches[i];
+        strreg_match &result = out[begin + i];
+        result.offset = match ? match.offset : STRREG_NPOS;
+        result.length = match ? match.length : 0;
+        result.rule = match ? ruleNumber(match.rule) : -1;
+        result.year = match ? static_cast<int>(match.year) : -1;
+      }
+    }
+    return found;
+  } catch (...) {
+    // 异常不能穿过 C 接口
+    return -1;
+  }
+}
+
+} // namespace
+
+extern "C" {
+
+strreg_years *strreg_years_new(const char *spec) {
+  if (spec == nullptr) {
+    return nullptr;
+  }
+  // YearSet 的构造和 parse 都会分配内存，异常不能穿过 C 接口
+  try {
+    std::unique_ptr<strreg_years> years(new strreg_years);
+    if (!years->years.parse(spec)) {
+      return nullptr;
+    }
+    return years.release();
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void strreg_years_free(strreg_years *years) { delete years; }
+
+int strreg_set_engine(const char *name) {
+  strreg::Engine engine;
+  if (name == nullptr || !strreg::parseEngine(name, engine)) {
+    return -1;
+  }
+  strreg::setDefaultEngine(engine);
+  return 0;
+}
+
+long strreg_validate_batch(const strreg_record *records, size_t count,
+                           const int *rules, size_t rule_count,
+                           const strreg_years *years, strreg_match *out) {
+  return runBatch(strreg::validateBatch, records, count, rules, rule_count,
+                  years, out);
+}
+
+long strreg_extract_batch(const strreg_record *records, size_t count,
+                          const int *rules, size_t rule_count,
+                          const strreg_years *years, strreg_match *out) {
+  return runBatch(strreg::extractBatch, records, count, rules, rule_count,
+                  years, out);
+}
+
+} // extern "C"
@@ -0,0 +1,85 @@
+/**
+ * @file strreg_c.h
+ * @brief strreg 库的 C 语言接口
+ *
+ * 供 C 程序或其他语言通过 FFI 调用。所有函数都不抛出异常；记录和结果都由
+ * 调用方分配，一次调用处理一整批记录。
+ */
+
+#ifndef STRREG_STRREG_C_H
+#define STRREG_STRREG_C_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 内置规则编号 */
+#define STRREG_CODE11 0 /**< 大端面11位规则 */
+#define STRREG_CODE8 1  /**< 大端面8位规则 */
+#define STRREG_CODE10 2 /**< 小端面10位规则 */
+
+/** 表示未找到的偏移 */
+#define STRREG_NPOS ((size_t)-1)
+
+/** 一条记录：调用方缓冲区中的一段字节，不要求以 NUL 结尾 */
+typedef struct strreg_record {
+  const char *data;
+  size_t length;
+} strreg_record;
+
+/** 一条记录的结果；未找到时 offset 为 STRREG_NPOS、length 为0 */
+typedef struct strreg_match {
+  size_t offset; /**< 匹配在记录中的起始偏移 */
+  size_t length; /**< 匹配长度 */
+  int rule;      /**< 匹配的规则编号 */
+  int year;      /**< 命中的年份在年份集合中的下标 */
+} strreg_match;
+
+/** 年份集合，由 strreg_years_new 创建 */
+typedef struct strreg_years strreg_years;
+
+/**
+ * @brief 解析年份列表，如 "25" 或 "20,22-26"
+ * @return 年份集合；格式错误或内存不足时返回 NULL
+ */
+strreg_years *strreg_years_new(const char *spec);
+
+/** 释放年份集合，可传入 NULL */
+void strreg_years_free(strreg_years *years);
+
+/**
+ * @brief 设置进程默认的查找引擎（"regex"、"table"、"static"、"automaton"）
+ * @return 成功返回0，名称无效返回-1
+ */
+int strreg_set_engine(const char *name);
+
+/**
+ * @brief 整条验证一批记录，每条按 rules 的顺序取第一条整体匹配的规则
+ * @param records 记录数组
+ * @param count 记录条数
+ * @param rules 规则编号数组，按优先级排列
+ * @param rule_count 规则个数
+ * @param years 年份集合
+ * @param out 结果数组，至少 count 个元素
+ * @return 符合规则的记录条数；参数无效或内存不足时返回-1
+ */
+long strreg_validate_batch(const strreg_record *records, size_t count,
+                           const int *rules, size_t rule_count,
+                           const strreg_years *years, strreg_match *out);
+
+/**
+ * @brief 在一批记录中各提取一个匹配：排在最前的、出现过的规则的第一个匹配
+ * 参数与返回值同 strreg_validate_batch；规则为 {STRREG_CODE11,
+ * STRREG_CODE8} 时与大端面的提取相同，为 {STRREG_CODE10} 时与小端面相同
+ */
+long strreg_extract_batch(const strreg_record *records, size_t count,
+                          const int *rules, size_t rule_count,
+                          const strreg_years *years, strreg_match *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STRREG_STRREG_C_H */
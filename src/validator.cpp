@@ -0,0 +1,189 @@
+/**
+ * @file validator.cpp
+ * @brief 预编译验证器及其进程级缓存的实现
+ */
+
+#include "validator.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "static_rules.h"
+
+namespace strreg {
+
+namespace {
+
+/**
+ * @brief 构建规则对应的正则表达式主体（不含锚点）
+ * - [45679] 表示第3位只能是4、5、6、7或9
+ * - [012] 表示第4位只能是0、1或2
+ * - .{4} 表示第5-8位可以是任意字符
+ * - 11位规则：[12345] 第9位，[012] 第10位，. 第11位
+ * - 10位规则：[A-G] 第9位，. 第10位
+ */
+std::string buildPatternBody(RuleId rule, std::string_view year) {
+  std::string body(year);
+  switch (rule) {
+  case RuleId::Code11:
+    return body + "[45679][012].{4}[12345][012].";
+  case RuleId::Code8:
+    return body + "[45679][012].{4}";
+  case RuleId::Code10:
+    return body + "[45679][012]....[A-G].";
+  }
+  return body;
+}
+
+struct CacheKey {
+  RuleId rule;
+  Engine engine;
+  std::string year;
+
+  bool operator<(const CacheKey &other) const {
+    if (rule != other.rule) {
+      return rule < other.rule;
+    }
+    if (engine != other.engine) {
+      return engine < other.engine;
+    }
+    return year < other.year;
+  }
+};
+
+std::atomic<Engine> &engineSetting() {
+  static std::atomic<Engine> engine(Engine::Regex);
+  return engine;
+}
+
+std::mutex &cacheMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::map<CacheKey, std::unique_ptr<Validator>> &cacheMap() {
+  static std::map<CacheKey, std::unique_ptr<Validator>> cache;
+  return cache;
+}
+
+} // namespace
+
+void setDefaultEngine(Engine engine) { engineSetting().store(engine); }
+
+Engine defaultEngine() { return engineSetting().load(); }
+
+bool parseEngine(const std::string &name, Engine &engine) {
+  if (name == "regex") {
+    engine = Engine::Regex;
+    return true;
+  }
+  if (name == "table") {
+    engine = Engine::Table;
+    return true;
+  }
+  if (name == "static") {
+    engine = Engine::Static;
+    return true;
+  }
+  if (name == "automaton") {
+    engine = Engine::Automaton;
+    return true;
+  }
+  return false;
+}
+
+std::size_t ruleLength(RuleId rule) {
+  switch (rule) {
+  case RuleId::Code11:
+    return 11;
+  case RuleId::Code8:
+    return 8;
+  case RuleId::Code10:
+    return 10;
+  }
+  return 0;
+}
+
+const char *ruleName(RuleId rule) {
+  switch (rule) {
+  case RuleId::Code11:
+    return "code11";
+  case RuleId::Code8:
+    return "code8";
+  case RuleId::Code10:
+    return "code10";
+  }
+  return "unknown";
+}
+
+Validator::Validator(RuleId rule, std::string_view year, Engine engine)
+    : rule_(rule), year_(year), length_(ruleLength(rule)), engine_(engine) {
+  // 只编译所选引擎需要的结构
+  if (engine_ == Engine::Regex) {
+    pattern_.assign("^" + buildPatternBody(rule, year) + "$");
+    search_.assign(buildPatternBody(rule, year));
+  } else {
+    matcher_ = FixedMatcher::compile(rule, year);
+  }
+}
+
+bool Validator::validate(std::string_view str) const {
+  // 长度不符时无需进入匹配引擎
+  if (str.length() != length_) {
+    return false;
+  }
+  // 验证单个定长字符串时组合自动机没有优势，与 Table 一样逐位查表
+  if (engine_ == Engine::Table || engine_ == Engine::Automaton) {
+    return matcher_.matchAt(str.data());
+  }
+  if (engine_ == Engine::Static) {
+    return staticValidate(str, rule_, year_);
+  }
+  return std::regex_match(str.begin(), str.end(), pattern_);
+}
+
+const Validator &getValidator(RuleId rule, std::string_view year,
+                              Engine engine) {
+  // 线程本地记住最近使用的几个验证器，交替使用不同规则时也无需加锁
+  const std::size_t kRecent = 8;
+  thread_local const Validator *recent[kRecent] = {};
+  thread_local std::size_t next = 0;
+  for (const Validator *v : recent) {
+    if (v != nullptr && v->rule() == rule && v->engine() == engine &&
+        v->year() == year) {
+      return *v;
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(cacheMutex());
+    std::map<CacheKey, std::unique_ptr<Validator>> &cache = cacheMap();
+    CacheKey key{rule, engine, std::string(year)};
+    auto it = cache.find(key);
+    if (it == cache.end() && year.length() == 2 &&
+        cache.size() < kMaxCachedValidators) {
+      it = cache.emplace(std::move(key),
+                         std::make_unique<Validator>(rule, year, engine))
+               .first;
+    }
+    if (it != cache.end()) {
+      recent[next] = it->second.get();
+      next = (next + 1) % kRecent;
+      return *it->second;
+    }
+  }
+
+  // 不进缓存的年份：在本线程的环形槽位中构造，槽位被覆盖后引用失效，
+  // 因此也不放进上面的 recent
+  const std::size_t kUncached = 4;
+  thread_local std::unique_ptr<Validator> uncached[kUncached];
+  thread_local std::size_t nextUncached = 0;
+  std::unique_ptr<Validator> &slot = uncached[nextUncached];
+  nextUncached = (nextUncached + 1) % kUncached;
+  slot = std::make_unique<Validator>(rule, year, engine);
+  return *slot;
+}
+
+} // namespace strreg
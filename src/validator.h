@@ -0,0 +1,148 @@
+/**
+ * @file validator.h
+ * @brief 预编译、可复用的编码验证器
+ *
+ * 每个 (规则, 年份) 组合只编译一次正则表达式，之后所有验证调用共用同一个对象。
+ */
+
+#ifndef STRREG_VALIDATOR_H
+#define STRREG_VALIDATOR_H
+
+#include <cstddef>
+#include <regex>
+#include <string>
+#include <string_view>
+
+#include "fixed_matcher.h"
+
+namespace strreg {
+
+/**
+ * @brief 内置的编码规则
+ */
+enum class RuleId {
+  Code11, ///< 大端面11位规则：^YY[45679][012].{4}[12345][012].$
+  Code8,  ///< 大端面8位规则：^YY[45679][012].{4}$
+  Code10  ///< 小端面10位规则：^YY[45679][012]....[A-G].$
+};
+
+/**
+ * @brief 验证引擎
+ */
+enum class Engine {
+  Regex, ///< std::regex 引擎（参考实现）
+  Table, ///< 逐位查表引擎，结果与 Regex 一致
+  Static, ///< 编译期展开的内置规则（static_rules.h），在长输入中查找时同 Table
+  /// 在长输入中查找时所有规则、年份共用一个组合自动机（automaton.h），
+  /// 验证单个字符串时同 Table
+  Automaton
+};
+
+/**
+ * @brief 设置进程默认使用的验证引擎，默认为 Engine::Regex
+ * @param engine 验证引擎
+ */
+void setDefaultEngine(Engine engine);
+
+/**
+ * @brief 返回进程默认使用的验证引擎
+ */
+Engine defaultEngine();
+
+/**
+ * @brief 按名称解析验证引擎（"regex"、"table"、"static" 或 "automaton"）
+ * @param name 引擎名称
+ * @param engine 解析结果
+ * @return 名称合法返回true，否则返回false
+ */
+bool parseEngine(const std::string &name, Engine &engine);
+
+/**
+ * @brief 返回规则要求的字符串长度
+ * @param rule 规则
+ * @return 规则对应的固定长度
+ */
+std::size_t ruleLength(RuleId rule);
+
+/**
+ * @brief 返回规则名称（"code11"、"code8"、"code10"），用于输出
+ */
+const char *ruleName(RuleId rule);
+
+/**
+ * @brief 绑定了规则、年份和引擎的验证器
+ * 构造时编译正则表达式或查找表，之后的验证调用不再重新编译
+ */
+class Validator {
+public:
+  /**
+   * @brief 构造验证器并编译正则表达式或查找表
+   * @param rule 使用的规则
+   * @param year 两位年份
+   * @param engine 使用的验证引擎
+   */
+  Validator(RuleId rule, std::string_view year,
+            Engine engine = Engine::Regex);
+
+  /**
+   * @brief 验证整个字符串是否符合规则
+   * @param str 需要验证的字符串
+   * @return 如果字符串符合规则返回true，否则返回false
+   */
+  bool validate(std::string_view str) const;
+
+  /**
+   * @brief 用于在长字符串中搜索的正则表达式（不带^和$锚点）
+   * 仅当引擎为 Engine::Regex 时有效
+   */
+  const std::regex &searchPattern() const { return search_; }
+
+  /**
+   * @brief 编译好的查找表，引擎不是 Engine::Regex 时有效
+   */
+  const FixedMatcher &matcher() const { return matcher_; }
+
+  RuleId rule() const { return rule_; }
+  const std::string &year() const { return year_; }
+  std::size_t length() const { return length_; }
+  Engine engine() const { return engine_; }
+
+private:
+  RuleId rule_;
+  std::string year_;
+  std::size_t length_;
+  Engine engine_;
+  std::regex pattern_;
+  std::regex search_;
+  FixedMatcher matcher_;
+};
+
+/// 进程级验证器缓存最多保存的验证器个数
+constexpr std::size_t kMaxCachedValidators = 4096;
+
+/**
+ * @brief 从进程级缓存中取得验证器，不存在时创建
+ * 缓存中的验证器从不删除，返回的引用在进程生命周期内一直有效，可在多个
+ * 线程中同时使用。只有两个字符的年份进缓存，且最多 kMaxCachedValidators
+ * 个（两位数字年份全部放入也只需 100 × 3 × 4 = 1200 个），因此调用方传入
+ * 任意年份时内存也有上限。其他年份以及缓存满后的新年份每次重新编译，
+ * 返回的引用只在本线程此后再取得4个这样的验证器之前有效
+ *
+ * @param rule 规则
+ * @param year 两位年份
+ * @param engine 使用的验证引擎
+ * @return 对应 (规则, 年份, 引擎) 的验证器
+ */
+const Validator &getValidator(RuleId rule, std::string_view year,
+                              Engine engine);
+
+/**
+ * @brief 使用进程默认引擎从缓存中取得验证器
+ */
+inline const Validator &getValidator(RuleId rule, std::string_view year) {
+  return getValidator(rule, year, defaultEngine());
+}
+
+} // namespace strreg
+
+#endif // STRREG_VALIDATOR_H
@@ -0,0 +1,234 @@
+/**
+ * @file verify.cpp
+ * @brief 差分校验程序（strreg_verify）
+ *
+ * 用固定种子生成随机输入和构造输入，逐一交给 DifferentialChecker，
+ * 比较各快速引擎与原始正则实现的结果。发现任何不一致时打印详情并返回1，
+ * 因此可以直接作为构建步骤或 CI 步骤运行。
+ *
+ * 用法：
+ *   strreg_verify [--iterations=N] [--seed=N]
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "differential.h"
+#include "fuzzy.h"
+
+namespace {
+
+using strreg::DifferentialChecker;
+
+/**
+ * @brief 校验输入生成器
+ * 字母表偏向规则中出现的字符，并混入换行、回车、NUL 和高位字节
+ */
+class InputGenerator {
+public:
+  explicit InputGenerator(std::uint64_t seed) : rng_(seed) {}
+
+  /// 随机选一个年份，大多数是数字年份
+  std::string year() {
+    static const char *const kYears[] = {"25", "24", "20", "99",
+                                         "00", "ab", "Z9", "55"};
+    return kYears[below(sizeof(kYears) / sizeof(kYears[0]))];
+  }
+
+  /// 长度为 length 的随机字节串
+  std::string noise(std::size_t length, const std::string &year) {
+    std::string text(length, ' ');
+    for (char &c : text) {
+      c = byte(year);
+    }
+    return text;
+  }
+
+  /// 一个符合 rule 长度（8、10 或 11）的编码，可能有一位被改坏
+  std::string code(std::size_t length, const std::string &year) {
+    std::string text = year;
+    text += pick("45679");
+    text += pick("012");
+    for (int i = 0; i < 4; ++i) {
+      text += anyChar();
+    }
+    if (length == 10) {
+      text += static_cast<char>('A' + below(7));
+      text += anyChar();
+    } else if (length == 11) {
+      text += pick("12345");
+      text += pick("012");
+      text += anyChar();
+    }
+    if (below(3) == 0) {
+      text[below(text.size())] = byte(year);
+    }
+    return text;
+  }
+
+  /// 一条记录：纯随机、单个编码或噪声中嵌入若干编码
+  std::string record(const std::string &year) {
+    static const std::size_t kLengths[] = {8, 10, 11};
+    switch (below(4)) {
+    case 0:
+      return noise(below(24), year);
+    case 1:
+      return code(kLengths[below(3)], year);
+    default: {
+      std::string text = noise(below(8), year);
+      for (std::size_t n = below(3) + 1; n > 0; --n) {
+        text += code(kLengths[below(3)], year);
+        text += noise(below(6), year);
+      }
+      return text;
+    }
+    }
+  }
+
+  /// 由一条记录切成的 minCount..maxCount 个片段，片段顺序随机
+  std::vector<std::string> fragments(const std::string &year,
+                                     std::size_t minCount = 1,
+                                     std::size_t maxCount = 4) {
+    std::string text = record(year);
+    std::size_t count = minCount + below(maxCount - minCount + 1);
+    std::vector<std::string> parts;
+    std::size_t start = 0;
+    for (std::size_t i = 1; i < count && start < text.size(); ++i) {
+      std::size_t length = below(text.size() - start + 1);
+      parts.push_back(text.substr(start, length));
+      start += length;
+    }
+    parts.push_back(text.substr(start));
+    std::shuffle(parts.begin(), parts.end(), rng_);
+    return parts;
+  }
+
+  /// 一条记录，其中部分字符换成 OCR 混淆表中的形近字符
+  std::string confused(const std::string &year) {
+    static const char kPairs[] = "O0I1S5B8";
+    std::string text = record(year);
+    for (char &c : text) {
+      const char *pair = std::strchr(kPairs, c);
+      if (c != '\0' && pair != nullptr && below(3) == 0) {
+        c = kPairs[(pair - kPairs) ^ 1];
+      }
+    }
+    return text;
+  }
+
+  /// 近似查找允许的替换数，1..kMaxErrors
+  std::size_t errors() {
+    return below(strreg::FuzzyScanner::kMaxErrors) + 1;
+  }
+
+  /// 互不相同的若干组片段，每组带一个编号片段以保证不同
+  std::vector<std::vector<std::string>> fragmentSets(const std::string &year) {
+    std::vector<std::vector<std::string>> sets(below(3) + 2);
+    for (std::size_t i = 0; i < sets.size(); ++i) {
+      sets[i] = fragments(year);
+      sets[i].push_back("#" + std::to_string(i));
+    }
+    return sets;
+  }
+
+  /// 片段较多的一组：一条记录切成的片段再补上短噪声片段，共8–10个
+  std::vector<std::string> manyFragments(const std::string &year) {
+    std::vector<std::string> parts = fragments(year);
+    const std::size_t count = 8 + below(3);
+    while (parts.size() < count) {
+      parts.push_back(noise(below(4) + 1, year));
+    }
+    std::shuffle(parts.begin(), parts.end(), rng_);
+    return parts;
+  }
+
+private:
+  std::size_t below(std::size_t n) { return n == 0 ? 0 : rng_() % n; }
+
+  char pick(const char *chars) {
+    return chars[below(std::char_traits<char>::length(chars))];
+  }
+
+  /// 正则表达式的 . 能匹配的字符
+  char anyChar() { return pick("0123456789ABGHxyz -_#"); }
+
+  char byte(const std::string &year) {
+    static const char kSpecial[] = {'\n', '\r', '\0', '\x80', '\xff'};
+    switch (below(8)) {
+    case 0:
+      return year[below(year.size())];
+    case 1:
+      return kSpecial[below(sizeof(kSpecial))];
+    case 2:
+      return pick("45679012");
+    case 3:
+      return static_cast<char>('A' + below(8));
+    default:
+      return anyChar();
+    }
+  }
+
+  std::mt19937_64 rng_;
+};
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::size_t iterations = 5000;
+  std::uint64_t seed = 20250101;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg.compare(0, 13, "--iterations=") == 0) {
+      iterations = std::strtoull(arg.c_str() + 13, nullptr, 10);
+    } else if (arg.compare(0, 7, "--seed=") == 0) {
+      seed = std::strtoull(arg.c_str() + 7, nullptr, 10);
+    } else {
+      std::fprintf(stderr, "未知参数：%s\n", arg.c_str());
+      return 1;
+    }
+  }
+
+  InputGenerator generator(seed);
+  DifferentialChecker checker;
+  for (std::size_t i = 0; i < iterations; ++i) {
+    std::string year = generator.year();
+    checker.checkRecord(generator.record(year), year);
+    if (i % 8 == 0) {
+      checker.checkFragments(generator.fragments(year), year);
+    }
+    // 原始实现枚举全部排列和子集，5–6个片段的比较很慢，只偶尔做一次
+    if (i % 256 == 0) {
+      checker.checkFragments(
+          generator.fragments(year, 5,
+                              DifferentialChecker::kMaxReferenceFragments),
+          year);
+    }
+    if (i % 4 == 0) {
+      checker.checkFuzzy(generator.confused(year), year, generator.errors());
+    }
+    if (i % 32 == 0) {
+      checker.checkParallelFragments(generator.manyFragments(year), year);
+    }
+    if (i % 256 == 0) {
+      checker.checkFragmentCache(generator.fragmentSets(year), year);
+    }
+  }
+
+  std::printf("差分校验：%zu 次比较，%zu 处不一致\n", checker.checks(),
+              checker.failures());
+  std::size_t shown = 0;
+  for (const strreg::Mismatch &m : checker.mismatches()) {
+    if (++shown > 10) {
+      break;
+    }
+    std::fprintf(stderr, "错误：%s 输入 \"%s\" 期望 %s 实际 %s\n",
+                 m.check.c_str(), m.input.c_str(), m.expected.c_str(),
+                 m.actual.c_str());
+  }
+  return checker.failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,332 @@
+/**
+ * @file window_scanner.cpp
+ * @brief 向量化滑动窗口扫描器的实现（SSE2/AVX2，运行时选择，标量兜底）
+ */
+
+#include "window_scanner.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "automaton.h"
+#include "validator.h"
+#include "years.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define STRREG_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace strreg {
+
+namespace {
+
+/// 一个扫描器最多包含的项数
+const std::size_t kMaxTerms =
+    WindowScanner::kMaxRules * FixedMatcher::kMaxLength;
+
+/// 一个字符类最多用几个区间表示才走向量化路径
+const std::size_t kMaxRanges = 4;
+
+/**
+ * @brief 把允许字节集合拆成连续区间
+ * @return 区间个数；超过 kMaxRanges 时只统计个数不写入
+ */
+std::size_t collectRanges(const bool allowed[256], bool value,
+                          unsigned char lo[], unsigned char hi[]) {
+  std::size_t count = 0;
+  unsigned c = 0;
+  while (c < 256) {
+    if (allowed[c] != value) {
+      ++c;
+      continue;
+    }
+    unsigned begin = c;
+    while (c < 256 && allowed[c] == value) {
+      ++c;
+    }
+    if (count < kMaxRanges) {
+      lo[count] = static_cast<unsigned char>(begin);
+      hi[count] = static_cast<unsigned char>(c - 1);
+    }
+    ++count;
+  }
+  return count;
+}
+
+bool sameTerm(const WindowScanner::Term &a, const WindowScanner::Term &b) {
+  if (a.pos != b.pos || a.rangeCount != b.rangeCount || a.negate != b.negate) {
+    return false;
+  }
+  for (std::size_t k = 0; k < a.rangeCount; ++k) {
+    if (a.lo[k] != b.lo[k] || a.hi[k] != b.hi[k]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+#ifdef STRREG_SCAN_X86
+
+__attribute__((target("sse2"))) void
+blockSse2(const std::vector<WindowScanner::Term> &terms,
+          const std::vector<std::vector<std::size_t>> &ruleTerms,
+          const char *p, std::uint32_t *masks) {
+  __m128i termMask[kMaxTerms];
+  const __m128i ones = _mm_set1_epi8(-1);
+  for (std::size_t t = 0; t < terms.size(); ++t) {
+    const WindowScanner::Term &term = terms[t];
+    __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + term.pos));
+    __m128i in = _mm_setzero_si128();
+    for (std::size_t k = 0; k < term.rangeCount; ++k) {
+      // 无符号区间比较：v - lo <= hi - lo
+      __m128i d = _mm_sub_epi8(v, _mm_set1_epi8(static_cast<char>(term.lo[k])));
+      __m128i span =
+          _mm_set1_epi8(static_cast<char>(term.hi[k] - term.lo[k]));
+      in = _mm_or_si128(in, _mm_cmpeq_epi8(_mm_min_epu8(d, span), d));
+    }
+    termMask[t] = term.negate ? _mm_xor_si128(in, ones) : in;
+  }
+  for (std::size_t r = 0; r < ruleTerms.size(); ++r) {
+    __m128i acc = ones;
+    for (std::size_t t : ruleTerms[r]) {
+      acc = _mm_and_si128(acc, termMask[t]);
+    }
+    masks[r] = static_cast<std::uint32_t>(_mm_movemask_epi8(acc)) & 0xFFFFu;
+  }
+}
+
+__attribute__((target("avx2"))) void
+blockAvx2(const std::vector<WindowScanner::Term> &terms,
+          const std::vector<std::vector<std::size_t>> &ruleTerms,
+          const char *p, std::uint32_t *masks) {
+  __m256i termMask[kMaxTerms];
+  const __m256i ones = _mm256_set1_epi8(-1);
+  for (std::size_t t = 0; t < terms.size(); ++t) {
+    const WindowScanner::Term &term = terms[t];
+    __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + term.pos));
+    __m256i in = _mm256_setzero_si256();
+    for (std::size_t k = 0; k < term.rangeCount; ++k) {
+      __m256i d =
+          _mm256_sub_epi8(v, _mm256_set1_epi8(static_cast<char>(term.lo[k])));
+      __m256i span =
+          _mm256_set1_epi8(static_cast<char>(term.hi[k] - term.lo[k]));
+      in = _mm256_or_si256(in, _mm256_cmpeq_epi8(_mm256_min_epu8(d, span), d));
+    }
+    termMask[t] = term.negate ? _mm256_xor_si256(in, ones) : in;
+  }
+  for (std::size_t r = 0; r < ruleTerms.size(); ++r) {
+    __m256i acc = ones;
+    for (std::size_t t : ruleTerms[r]) {
+      acc = _mm256_and_si256(acc, termMask[t]);
+    }
+    masks[r] = static_cast<std::uint32_t>(_mm256_movemask_epi8(acc));
+  }
+}
+
+#endif // STRREG_SCAN_X86
+
+struct ScannerKey {
+  std::vector<RuleId> rules;
+  std::string year;
+
+  bool operator<(const ScannerKey &other) const {
+    if (rules != other.rules) {
+      return rules < other.rules;
+    }
+    return year < other.year;
+  }
+};
+
+} // namespace
+
+ScanIsa detectScanIsa() {
+#ifdef STRREG_SCAN_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return ScanIsa::AVX2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return ScanIsa::SSE2;
+  }
+#endif
+  return ScanIsa::Scalar;
+}
+
+const char *scanIsaName(ScanIsa isa) {
+  switch (isa) {
+  case ScanIsa::Scalar:
+    return "scalar";
+  case ScanIsa::SSE2:
+    return "sse2";
+  case ScanIsa::AVX2:
+    return "avx2";
+  }
+  return "unknown";
+}
+
+WindowScanner::WindowScanner(const std::vector<FixedMatcher> &matchers,
+                             ScanIsa isa)
+    : matchers_(matchers), minLength_(FixedMatcher::kMaxLength),
+      maxLength_(0), isa_(isa) {
+  if (matchers_.size() > kMaxRules) {
+    matchers_.resize(kMaxRules);
+  }
+  if (static_cast<int>(isa_) > static_cast<int>(detectScanIsa())) {
+    isa_ = detectScanIsa();
+  }
+
+  bool vectorizable = true;
+  ruleTerms_.resize(matchers_.size());
+  for (std::size_t r = 0; r < matchers_.size(); ++r) {
+    const FixedMatcher &m = matchers_[r];
+    minLength_ = std::min(minLength_, m.length());
+    maxLength_ = std::max(maxLength_, m.length());
+
+    for (std::size_t pos = 0; pos < m.length(); ++pos) {
+      bool allowed[256];
+      for (unsigned c = 0; c < 256; ++c) {
+        allowed[c] = m.allows(pos, static_cast<unsigned char>(c));
+      }
+
+      // 允许集合和它的补集，哪个区间少就用哪个
+      Term term = Term();
+      term.pos = pos;
+      Term inverse = Term();
+      inverse.pos = pos;
+      inverse.negate = true;
+      term.rangeCount = collectRanges(allowed, true, term.lo, term.hi);
+      inverse.rangeCount =
+          collectRanges(allowed, false, inverse.lo, inverse.hi);
+      if (inverse.rangeCount < term.rangeCount) {
+        term = inverse;
+      }
+      if (term.negate && term.rangeCount == 0) {
+        continue; // 允许任意字节，无需检查
+      }
+      if (term.rangeCount > kMaxRanges) {
+        vectorizable = false;
+        continue;
+      }
+
+      std::size_t index = 0;
+      while (index < terms_.size() && !sameTerm(terms_[index], term)) {
+        ++index;
+      }
+      if (index == terms_.size()) {
+        terms_.push_back(term);
+      }
+      ruleTerms_[r].push_back(index);
+    }
+  }
+
+  if (!vectorizable || matchers_.empty()) {
+    isa_ = ScanIsa::Scalar;
+  }
+}
+
+WindowScanner::~WindowScanner() = default;
+
+const AutomatonScanner &WindowScanner::automaton() const {
+  std::call_once(automatonOnce_, [this] {
+    automaton_ = std::make_unique<AutomatonScanner>(matchers_);
+  });
+  return *automaton_;
+}
+
+std::size_t WindowScanner::scanBlock(const char *data, std::size_t len,
+                                     std::size_t start,
+                                     std::uint32_t *masks) const {
+  if (matchers_.empty() || start + minLength_ > len) {
+    return 0;
+  }
+#ifdef STRREG_SCAN_X86
+  // 向量化路径要求整块的每个窗口都完整落在缓冲区内
+  if (isa_ == ScanIsa::AVX2 && start + 32 + maxLength_ - 1 <= len) {
+    blockAvx2(terms_, ruleTerms_, data + start, masks);
+    return 32;
+  }
+  if (isa_ != ScanIsa::Scalar && start + 16 + maxLength_ - 1 <= len) {
+    blockSse2(terms_, ruleTerms_, data + start, masks);
+    return 16;
+  }
+#endif
+  return scanScalar(data, len, start, masks);
+}
+
+std::size_t WindowScanner::scanScalar(const char *data, std::size_t len,
+                                      std::size_t start,
+                                      std::uint32_t *masks) const {
+  std::size_t width = len - minLength_ + 1 - start;
+  if (width > 32) {
+    width = 32;
+  }
+  for (std::size_t r = 0; r < matchers_.size(); ++r) {
+    const FixedMatcher &m = matchers_[r];
+    std::uint32_t mask = 0;
+    for (std::size_t b = 0; b < width && start + b + m.length() <= len; ++b) {
+      mask |= static_cast<std::uint32_t>(m.matchAt(data + start + b)) << b;
+    }
+    masks[r] = mask;
+  }
+  return width;
+}
+
+namespace {
+
+/**
+ * @brief 扫描器缓存的查找；key 为单个年份或 YearSet::key()
+ * years 非空时按年份集合编译。单个年份的集合与该年份编译结果相同，可共用缓存项
+ */
+const WindowScanner &lookupScanner(const RuleId *rules, std::size_t count,
+                                   std::string_view key,
+                                   const YearSet *years) {
+  static std::mutex mutex;
+  static std::map<ScannerKey, std::unique_ptr<WindowScanner>> cache;
+
+  // 线程本地记住上一次使用的扫描器，连续相同参数的调用无需加锁
+  thread_local const ScannerKey *lastKey = nullptr;
+  thread_local const WindowScanner *last = nullptr;
+  if (lastKey != nullptr && lastKey->year == key &&
+      std::equal(rules, rules + count, lastKey->rules.begin(),
+                 lastKey->rules.end())) {
+    return *last;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  ScannerKey cacheKey{std::vector<RuleId>(rules, rules + count),
+                      std::string(key)};
+  auto it = cache.find(cacheKey);
+  if (it == cache.end()) {
+    std::vector<FixedMatcher> matchers;
+    for (RuleId rule : cacheKey.rules) {
+      matchers.push_back(years != nullptr ? FixedMatcher::compile(rule, *years)
+                                          : FixedMatcher::compile(rule, key));
+    }
+    it = cache
+             .emplace(cacheKey, std::make_unique<WindowScanner>(matchers))
+             .first;
+  }
+  lastKey = &it->first;
+  last = it->second.get();
+  return *last;
+}
+
+} // namespace
+
+const WindowScanner &getWindowScanner(const RuleId *rules, std::size_t count,
+                                      std::string_view year) {
+  return lookupScanner(rules, count, year, nullptr);
+}
+
+const WindowScanner &getWindowScanner(const RuleId *rules, std::size_t count,
+                                      const YearSet &years) {
+  return lookupScanner(rules, count, years.key(), &years);
+}
+
+} // namespace strreg
@@ -0,0 +1,208 @@
+/**
+ * @file window_scanner.h
+ * @brief 一次扫描整个缓冲区、找出所有定长匹配窗口的向量化扫描器
+ *
+ * 扫描器把每条规则拆成“第 p 位属于字符类 C”的若干项，对一整块偏移
+ * （SSE2 为16个，AVX2 为32个）同时计算每一项的位掩码，再把同一规则的
+ * 各项掩码按位与，得到这一块中所有匹配的起始偏移。多条规则共享相同的项，
+ * 因此11位规则和8位规则可以在同一趟扫描中完成。
+ */
+
+#ifndef STRREG_WINDOW_SCANNER_H
+#define STRREG_WINDOW_SCANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "fixed_matcher.h"
+
+namespace strreg {
+
+enum class RuleId;
+class YearSet;
+class AutomatonScanner;
+
+/**
+ * @brief 扫描器使用的指令集
+ */
+enum class ScanIsa {
+  Scalar, ///< 纯标量实现，所有平台可用
+  SSE2,   ///< 每块16个偏移
+  AVX2    ///< 每块32个偏移
+};
+
+/**
+ * @brief 运行时检测当前CPU支持的最佳指令集
+ */
+ScanIsa detectScanIsa();
+
+/**
+ * @brief 返回指令集名称，便于输出诊断信息
+ */
+const char *scanIsaName(ScanIsa isa);
+
+/**
+ * @brief 多规则滑动窗口扫描器
+ */
+class WindowScanner {
+public:
+  /// 一个扫描器最多包含的规则数
+  static const std::size_t kMaxRules = 32;
+
+  /**
+   * @brief 由若干匹配器构造扫描器
+   * @param matchers 参与扫描的匹配器，回调中的规则序号即其下标
+   * @param isa 希望使用的指令集，CPU不支持时自动降级
+   */
+  explicit WindowScanner(const std::vector<FixedMatcher> &matchers,
+                         ScanIsa isa = detectScanIsa());
+  ~WindowScanner();
+
+  /**
+   * @brief 扫描缓冲区，按偏移从小到大（同一偏移按规则序号）回调每个匹配
+   * @param data 缓冲区起始地址
+   * @param len 缓冲区长度
+   * @param fn 回调 bool fn(std::size_t rule, std::size_t offset)，
+   *           返回false时立即停止扫描
+   */
+  template <class Fn> void scan(const char *data, std::size_t len, Fn fn) const;
+
+  std::size_t ruleCount() const { return matchers_.size(); }
+  const FixedMatcher &matcher(std::size_t rule) const {
+    return matchers_[rule];
+  }
+  ScanIsa isa() const { return isa_; }
+  /// 最长规则的长度；分块扫描时相邻块需要重叠 maxLength() - 1 个字节
+  std::size_t maxLength() const { return maxLength_; }
+
+  /**
+   * @brief 由同一组匹配器构建的组合自动机（automaton.h），首次调用时构建
+   * 规则多时每字节的耗时不随规则数增长，见 scanWindows
+   */
+  const AutomatonScanner &automaton() const;
+
+  /// 字符类的区间表示，用于向量化的区间比较
+  struct Term {
+    std::size_t pos;
+    std::size_t rangeCount;
+    bool negate;
+    unsigned char lo[4];
+    unsigned char hi[4];
+  };
+
+private:
+  /**
+   * @brief 计算从 start 开始的一块偏移的匹配掩码
+   * masks[r] 的第 b 位表示规则 r 在偏移 start + b 处匹配
+   * @return 本块覆盖的偏移个数，0表示已无可扫描的偏移
+   */
+  std::size_t scanBlock(const char *data, std::size_t len, std::size_t start,
+                        std::uint32_t *masks) const;
+
+  std::size_t scanScalar(const char *data, std::size_t len, std::size_t start,
+                         std::uint32_t *masks) const;
+
+  std::vector<FixedMatcher> matchers_;
+  std::vector<Term> terms_;
+  std::vector<std::vector<std::size_t>> ruleTerms_;
+  std::size_t minLength_;
+  std::size_t maxLength_;
+  ScanIsa isa_;
+  mutable std::once_flag automatonOnce_;
+  mutable std::unique_ptr<AutomatonScanner> automaton_;
+};
+
+/**
+ * @brief 从进程级缓存中取得由查表引擎编译的扫描器
+ * 命中缓存时不分配内存
+ *
+ * @param rules 规则数组，回调中的规则序号即其下标
+ * @param count 规则个数
+ * @param year 两位年份
+ * @return 缓存的扫描器，进程生命周期内有效
+ */
+const WindowScanner &getWindowScanner(const RuleId *rules, std::size_t count,
+                                      std::string_view year);
+
+inline const WindowScanner &
+getWindowScanner(std::initializer_list<RuleId> rules, std::string_view year) {
+  return getWindowScanner(rules.begin(), rules.size(), year);
+}
+
+inline const WindowScanner &getWindowScanner(const std::vector<RuleId> &rules,
+                                             std::string_view year) {
+  return getWindowScanner(rules.data(), rules.size(), year);
+}
+
+/**
+ * @brief 从进程级缓存中取得接受多个年份的扫描器
+ * 年份两位按 FixedMatcher::compile(RuleId, const YearSet &) 放宽，
+ * 回调中还需用 YearSet::indexOf 确认窗口的年份
+ *
+ * @param rules 规则数组，回调中的规则序号即其下标
+ * @param count 规则个数
+ * @param years 年份集合
+ * @return 缓存的扫描器，进程生命周期内有效
+ */
+const WindowScanner &getWindowScanner(const RuleId *rules, std::size_t count,
+                                      const YearSet &years);
+
+inline const WindowScanner &
+getWindowScanner(std::initializer_list<RuleId> rules, const YearSet &years) {
+  return getWindowScanner(rules.begin(), rules.size(), years);
+}
+
+/**
+ * @brief 返回非零整数最低置位的下标
+ */
+inline unsigned lowestBit(std::uint32_t x) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, x);
+  return static_cast<unsigned>(index);
+#else
+  return static_cast<unsigned>(__builtin_ctz(x));
+#endif
+}
+
+template <class Fn>
+void WindowScanner::scan(const char *data, std::size_t len, Fn fn) const {
+  std::uint32_t masks[kMaxRules];
+  const std::size_t rules = matchers_.size();
+  std::size_t start = 0;
+  for (;;) {
+    std::size_t width = scanBlock(data, len, start, masks);
+    if (width == 0) {
+      return;
+    }
+    std::uint32_t any = 0;
+    for (std::size_t r = 0; r < rules; ++r) {
+      any |= masks[r];
+    }
+    while (any != 0) {
+      unsigned bit = lowestBit(any);
+      any &= any - 1;
+      for (std::size_t r = 0; r < rules; ++r) {
+        if ((masks[r] >> bit) & 1u) {
+          if (!fn(r, start + bit)) {
+            return;
+          }
+        }
+      }
+    }
+    start += width;
+  }
+}
+
+} // namespace strreg
+
+#endif // STRREG_WINDOW_SCANNER_H
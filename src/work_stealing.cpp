@@ -0,0 +1,155 @@
+/**
+ * @file work_stealing.cpp
+ * @brief 工作窃取线程池的实现
+ */
+
+#include "work_stealing.h"
+
+#include <utility>
+
+namespace strreg {
+
+namespace {
+
+/// 当前线程所属的线程池及其队列下标，非工作线程为空
+thread_local const WorkStealingPool *currentPool = nullptr;
+thread_local std::size_t currentQueue = 0;
+
+} // namespace
+
+WorkStealingPool::WorkStealingPool(std::size_t threads) {
+  if (threads == 0) {
+    threads = std::thread::hardware_concurrency();
+  }
+  if (threads == 0) {
+    threads = 1;
+  }
+  for (std::size_t i = 0; i < threads; ++i) {
+    queues_.push_back(std::make_unique<Queue>());
+  }
+  for (std::size_t i = 0; i < threads; ++i) {
+    threads_.emplace_back([this, i] { workLoop(i); });
+  }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread &thread : threads_) {
+    thread.join();
+  }
+}
+
+void WorkStealingPool::push(Task task) {
+  // 工作线程产生的任务放进自己的队列，其他线程的任务轮流分给各队列
+  std::size_t index = currentPool == this
+                          ? currentQueue
+                          : nextQueue_.fetch_add(1, std::memory_order_relaxed) %
+                                queues_.size();
+  {
+    std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+    queues_[index]->tasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex_);
+    queued_.fetch_add(1, std::memory_order_relaxed);
+  }
+  wake_.notify_one();
+}
+
+bool WorkStealingPool::take(std::size_t self, Task &task) {
+  if (queued_.load(std::memory_order_relaxed) == 0) {
+    return false;
+  }
+  const std::size_t count = queues_.size();
+  for (std::size_t i = 0; i < count; ++i) {
+    std::size_t index = (self + i) % count;
+    Queue &queue = *queues_[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+      continue;
+    }
+    // 自己的队列后进先出，保持局部性；窃取时先进先出，拿走较大的任务
+    if (i == 0 && currentPool == this) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    } else {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    }
+    queued_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+  return false;
+}
+
+void WorkStealingPool::execute(Task &task) {
+  task.run();
+  task.group->finishOne();
+}
+
+void WorkStealingPool::workLoop(std::size_t index) {
+  currentPool = this;
+  currentQueue = index;
+  Task task;
+  for (;;) {
+    if (take(index, task)) {
+      execute(task);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(sleepMutex_);
+    wake_.wait(lock, [this] {
+      return stopping_ || queued_.load(std::memory_order_relaxed) != 0;
+    });
+    if (stopping_ && queued_.load(std::memory_order_relaxed) == 0) {
+      return;
+    }
+  }
+}
+
+void TaskGroup::spawn(std::function<void()> task) {
+  pending_.fetch_add(1, std::memory_order_relaxed);
+  pool_.push(WorkStealingPool::Task{std::move(task), this});
+  // 正在 wait 中阻塞的线程醒来帮忙执行新任务；加锁避免错过通知
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+  }
+  done_.notify_all();
+}
+
+void TaskGroup::finishOne() {
+  // 在锁内递减：wait 返回前会获取同一把锁，保证这里已不再访问任务组
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    done_.notify_all();
+  }
+}
+
+void TaskGroup::wait() {
+  std::size_t self = currentPool == &pool_ ? currentQueue : 0;
+  WorkStealingPool::Task task;
+  while (pending_.load(std::memory_order_acquire) != 0) {
+    if (pool_.take(self, task)) {
+      pool_.execute(task);
+      continue;
+    }
+    // 剩下的任务都在其他线程上执行：阻塞到最后一个任务完成，或组内又
+    // 提交了新任务（此时醒来帮忙执行），不再定时轮询
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] {
+      return pending_.load(std::memory_order_acquire) == 0 ||
+             pool_.queued_.load(std::memory_order_relaxed) != 0;
+    });
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+}
+
+WorkStealingPool &defaultPool() {
+  static WorkStealingPool pool;
+  return pool;
+}
+
+} // namespace strreg
@@ -0,0 +1,105 @@
+/**
+ * @file work_stealing.h
+ * @brief 工作窃取线程池
+ *
+ * 每个工作线程有自己的任务队列，从队尾取自己的任务，空闲时从其他线程的
+ * 队头窃取。任务粒度不均匀时（如片段搜索中各子树大小相差悬殊），空闲线程
+ * 会自动分担耗时长的队列。等待任务组完成的线程也会参与执行任务。
+ */
+
+#ifndef STRREG_WORK_STEALING_H
+#define STRREG_WORK_STEALING_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace strreg {
+
+class TaskGroup;
+
+/**
+ * @brief 工作窃取线程池
+ */
+class WorkStealingPool {
+public:
+  /**
+   * @brief 启动线程池
+   * @param threads 工作线程数，为零时使用硬件线程数
+   */
+  explicit WorkStealingPool(std::size_t threads = 0);
+  ~WorkStealingPool();
+  WorkStealingPool(const WorkStealingPool &) = delete;
+  WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+  std::size_t size() const { return queues_.size(); }
+
+private:
+  friend class TaskGroup;
+
+  struct Task {
+    std::function<void()> run;
+    TaskGroup *group;
+  };
+
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void push(Task task);
+  /// 先从 self 的队尾取，再从其他队列的队头窃取
+  bool take(std::size_t self, Task &task);
+  void execute(Task &task);
+  void workLoop(std::size_t index);
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> threads_;
+  std::atomic<std::size_t> nextQueue_{0};
+  std::atomic<std::size_t> queued_{0};
+  std::mutex sleepMutex_;
+  std::condition_variable wake_;
+  bool stopping_ = false;
+};
+
+/**
+ * @brief 一组任务，wait 返回时组内任务全部执行完毕
+ */
+class TaskGroup {
+public:
+  explicit TaskGroup(WorkStealingPool &pool) : pool_(pool) {}
+  ~TaskGroup() { wait(); }
+  TaskGroup(const TaskGroup &) = delete;
+  TaskGroup &operator=(const TaskGroup &) = delete;
+
+  /// 提交一个任务
+  void spawn(std::function<void()> task);
+
+  /// 等待组内全部任务完成；等待期间当前线程也执行池中的任务
+  void wait();
+
+private:
+  friend class WorkStealingPool;
+
+  void finishOne();
+
+  WorkStealingPool &pool_;
+  std::atomic<std::size_t> pending_{0};
+  std::mutex mutex_;
+  std::condition_variable done_;
+};
+
+/**
+ * @brief 进程共用的线程池，线程数为硬件线程数，首次使用时创建
+ */
+WorkStealingPool &defaultPool();
+
+} // namespace strreg
+
+#endif // STRREG_WORK_STEALING_H
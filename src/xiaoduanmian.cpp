@@ -8,12 +8,20 @@
  * 4. 第9位只能是A、B、C、D、E、F、G
  */
 
-#include <algorithm>
 #include <iostream>
 #include <regex>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "automaton.h"
+#include "batch.h"
+#include "extract.h"
+#include "fragments.h"
+#include "metrics.h"
+#include "validator.h"
+#include "window_scanner.h"
+
 /**
  * @brief 使用正则表达式验证字符串是否符合特定格式
  * @param str 需要验证的字符串
@@ -26,15 +34,9 @@ bool validateString(const std::string &str, const std::string &year = "25") {
     return false;
   }
 
-  // 构建正则表达式模式
   // 前两位是指定年份，第3位是[45679]，第4位是[012]，第9位是[A-G]
-  std::string pattern = "^" + year + "[45679][012]....[A-G].$";
-
-  // 创建正则表达式对象
-  std::regex regex_pattern(pattern);
-
-  // 使用正则表达式匹配字符串
-  return std::regex_match(str, regex_pattern);
+  // 正则表达式按 (规则, 年份) 只编译一次，之后从缓存中取用
+  return strreg::validate(str, strreg::RuleId::Code10, year);
 }
 
 /**
@@ -52,9 +54,28 @@ std::vector<std::string> extractValidStrings(const std::string &input,
     return results;
   }
 
-  // 构建正则表达式模式，用于搜索符合条件的子串
-  std::string pattern = year + "[45679][012]....[A-G].";
-  std::regex regex_pattern(pattern);
+  const strreg::Validator &validator =
+      strreg::getValidator(strreg::RuleId::Code10, year);
+
+  // 查表引擎：向量化扫描器一趟找出所有匹配的起点，
+  // 再与正则搜索一样只保留从左到右互不重叠的匹配项
+  if (validator.engine() != strreg::Engine::Regex) {
+    const strreg::WindowScanner &scanner =
+        strreg::getWindowScanner({strreg::RuleId::Code10}, year);
+    size_t next = 0;
+    strreg::scanWindows(scanner, input.data(), input.length(),
+                        [&](size_t, size_t offset) {
+                          if (offset >= next) {
+                            results.push_back(input.substr(offset, 10));
+                            next = offset + 10;
+                          }
+                          return true;
+                        });
+    return results;
+  }
+
+  // 取得预编译的搜索模式，用于搜索符合条件的子串
+  const std::regex &regex_pattern = validator.searchPattern();
 
   // 在输入字符串中搜索所有匹配项
   std::sregex_iterator it(input.begin(), input.end(), regex_pattern);
@@ -69,89 +90,62 @@ std::vector<std::string> extractValidStrings(const std::string &input,
   return results;
 }
 
-/**
- * @brief 递归函数，生成所有可能的字符串片段组合
- * @param fragments 字符串片段数组
- * @param current 当前组合的字符串
- * @param index 当前处理的片段索引
- * @param results 存储所有组合结果的数组
- */
-void generateCombinations(const std::vector<std::string> &fragments,
-                          std::string current, size_t index,
-                          std::vector<std::string> &results) {
-  // 将当前组合添加到结果中
-  if (!current.empty()) {
-    results.push_back(current);
-  }
-
-  // 已经处理完所有片段，返回
-  if (index >= fragments.size()) {
-    return;
-  }
-
-  // 递归生成组合：选择当前片段
-  generateCombinations(fragments, current + fragments[index], index + 1,
-                       results);
-
-  // 递归生成组合：不选择当前片段
-  generateCombinations(fragments, current, index + 1, results);
-}
-
 /**
  * @brief 从字符串片段数组中提取满足正则表达式的字符串
+ * 结果等同于对片段的每种排列、每种子集组合调用 extractValidStrings 后去重，
+ * 但由 strreg::extractFromFragments 逐片段推进搜索，不再枚举全部组合
+ *
  * @param fragments 字符串片段数组
  * @param year 指定的年份，默认为"25"
+ * @param limit 最多返回的字符串个数，找到这么多个后立即停止搜索
  * @return 符合规则的字符串列表
  */
 std::vector<std::string>
 extractFromFragments(const std::vector<std::string> &fragments,
-                     const std::string &year = "25") {
-  std::vector<std::string> results;
-
-  // 如果没有片段，直接返回空结果
-  if (fragments.empty()) {
-    return results;
-  }
-
-  // 生成所有可能的片段排列
-  std::vector<std::string> allPermutations = fragments;
-  std::sort(allPermutations.begin(), allPermutations.end());
-
-  std::vector<std::string> validResults;
-
-  // 对每种排列生成所有可能的组合
-  do {
-    // 生成这个排列的所有组合
-    std::vector<std::string> combinations;
-    generateCombinations(allPermutations, "", 0, combinations);
-
-    // 检查每个组合是否包含符合要求的子串
-    for (const auto &combination : combinations) {
-      // 从组合中提取符合要求的子串
-      std::vector<std::string> extracted =
-          extractValidStrings(combination, year);
-
-      // 将符合要求的子串添加到结果中
-      validResults.insert(validResults.end(), extracted.begin(),
-                          extracted.end());
-    }
-
-  } while (
-      std::next_permutation(allPermutations.begin(), allPermutations.end()));
-
-  // 去除重复的结果
-  std::sort(validResults.begin(), validResults.end());
-  validResults.erase(std::unique(validResults.begin(), validResults.end()),
-                     validResults.end());
-
-  return validResults;
+                     const std::string &year = "25",
+                     std::size_t limit = strreg::kAllFragmentHits) {
+  std::vector<std::string_view> views(fragments.begin(), fragments.end());
+  return strreg::extractFromFragments(views, year, limit);
 }
 
 /**
  * @brief 主函数 - 程序的入口点
+ * 支持的参数：
+ * - --engine=regex|table|static|automaton 选择验证引擎（默认regex）
+ * - --batch 批处理模式，配合 --mode=validate|extract|find-all、
+ *   --year=YY（或 22-26 这样的年份列表）、--input=FILE（默认标准输入）、
+ *   --threads=N、--chunk-size=BYTES、--mmap、--stream 使用；
+ *   --fuzzy=K 允许至多K处 OCR 混淆替换（混淆表由 --confusions=O0,I1,S5,B8
+ *   给出）
+ * - --metrics=text|json 退出时以及收到 SIGUSR1 时把运行指标写到标准错误
+ *   （构建时需开启 STRREG_METRICS）
  * @return 返回程序执行的状态码，0表示正常退出
  */
-int main() {
+int main(int argc, char *argv[]) {
+  strreg::BatchOptions options;
+  options.family = strreg::Family::Xiaoduanmian;
+  bool batch = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    strreg::Engine engine;
+    if (arg.compare(0, 9, "--engine=") == 0 &&
+        strreg::parseEngine(arg.substr(9), engine)) {
+      strreg::setDefaultEngine(engine);
+    } else if (arg == "--batch") {
+      batch = true;
+    } else if (strreg::metrics::parseArgument(arg)) {
+      // 退出时或收到 SIGUSR1 时写出指标
+    } else if (!strreg::parseBatchArgument(arg, options)) {
+      std::cerr << "未知参数：" << arg << std::endl;
+      return 1;
+    }
+  }
+
+  // 批处理模式：从文件或标准输入逐条读取记录
+  if (batch) {
+    return strreg::runBatch(options);
+  }
+
   // 欢迎信息
   std::cout << "字符串格式验证程序" << std::endl;
   std::cout << "规则：\n"
@@ -0,0 +1,86 @@
+/**
+ * @file years.cpp
+ * @brief 年份集合的实现
+ */
+
+#include "years.h"
+
+#include <utility>
+
+namespace strreg {
+
+namespace {
+
+bool isTwoDigits(std::string_view text) {
+  return text.length() == 2 && text[0] >= '0' && text[0] <= '9' &&
+         text[1] >= '0' && text[1] <= '9';
+}
+
+int twoDigitValue(std::string_view text) {
+  return (text[0] - '0') * 10 + (text[1] - '0');
+}
+
+} // namespace
+
+YearSet::YearSet() : index_(1 << 16, kNone) {}
+
+YearSet::YearSet(std::string_view year) : YearSet() { add(year); }
+
+bool YearSet::add(std::string_view year) {
+  // 与区间一样只接受数字，单个年份和区间的写法行为一致
+  if (!isTwoDigits(year)) {
+    return false;
+  }
+  if (indexOf(year.data()) != npos) {
+    return true;
+  }
+  if (size() >= kMaxYears) {
+    return false;
+  }
+  index_[static_cast<unsigned char>(year[0]) << 8 |
+         static_cast<unsigned char>(year[1])] =
+      static_cast<std::uint8_t>(size());
+  years_.append(year.data(), 2);
+  return true;
+}
+
+bool YearSet::parse(std::string_view spec) {
+  YearSet parsed;
+  while (!spec.empty()) {
+    std::size_t comma = spec.find(',');
+    std::string_view item = spec.substr(0, comma);
+    spec = comma == std::string_view::npos ? std::string_view()
+                                           : spec.substr(comma + 1);
+
+    std::size_t dash = item.find('-');
+    if (dash == std::string_view::npos) {
+      if (!parsed.add(item)) {
+        return false;
+      }
+      continue;
+    }
+
+    // 区间的两端都必须是两位数字
+    std::string_view first = item.substr(0, dash);
+    std::string_view last = item.substr(dash + 1);
+    if (!isTwoDigits(first) || !isTwoDigits(last) ||
+        twoDigitValue(first) > twoDigitValue(last)) {
+      return false;
+    }
+    for (int value = twoDigitValue(first); value <= twoDigitValue(last);
+         ++value) {
+      const char year[2] = {static_cast<char>('0' + value / 10),
+                            static_cast<char>('0' + value % 10)};
+      if (!parsed.add(std::string_view(year, 2))) {
+        return false;
+      }
+    }
+  }
+  if (parsed.empty()) {
+    return false;
+  }
+  *this = std::move(parsed);
+  return true;
+}
+
+} // namespace strreg
@@ -0,0 +1,87 @@
+/**
+ * @file years.h
+ * @brief 一次扫描同时接受多个年份的年份集合
+ *
+ * 年份集合把“前两位是哪个年份”编成一张以两个字节为下标的查找表，
+ * 判断一个窗口的年份只需一次查表，代价与接受的年份个数无关。
+ */
+
+#ifndef STRREG_YEARS_H
+#define STRREG_YEARS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace strreg {
+
+/**
+ * @brief 一组两位年份
+ */
+class YearSet {
+public:
+  /// indexOf 表示不在集合中的返回值
+  static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+  /// 一个集合最多包含的年份数
+  static const std::size_t kMaxYears = 255;
+
+  YearSet();
+
+  /**
+   * @brief 由单个两位年份构造
+   * @param year 两位年份；不是两位数字时得到空集合
+   */
+  explicit YearSet(std::string_view year);
+
+  /**
+   * @brief 加入一个年份，已存在时忽略
+   * @param year 两位年份，只能是数字
+   * @return 年份是两位数字且集合未满时返回true
+   */
+  bool add(std::string_view year);
+
+  /**
+   * @brief 解析年份列表并替换当前内容
+   * 格式为逗号分隔的若干项，每项是一个两位数字年份（如 25）
+   * 或两位数字的闭区间（如 22-26），例如 "20,22-26"
+   *
+   * @param spec 年份列表
+   * @return 解析成功且至少有一个年份时返回true；失败时集合内容不变
+   */
+  bool parse(std::string_view spec);
+
+  std::size_t size() const { return years_.size() / 2; }
+  bool empty() const { return years_.empty(); }
+
+  /// 第 index 个年份（按加入顺序）
+  std::string_view year(std::size_t index) const {
+    return std::string_view(years_).substr(index * 2, 2);
+  }
+
+  /**
+   * @brief 查找以 prefix 开头的两个字节对应的年份
+   * @param prefix 至少有两个字节可读的地址
+   * @return 年份在集合中的下标；不在集合中时返回 npos
+   */
+  std::size_t indexOf(const char *prefix) const {
+    std::uint8_t index =
+        index_[static_cast<unsigned char>(prefix[0]) << 8 |
+               static_cast<unsigned char>(prefix[1])];
+    return index == kNone ? npos : index;
+  }
+
+  /// 全部年份按加入顺序首尾相接，可用作缓存的键
+  const std::string &key() const { return years_; }
+
+private:
+  static constexpr std::uint8_t kNone = 0xff;
+
+  std::string years_;
+  std::vector<std::uint8_t> index_; ///< 65536项，下标为前两个字节
+};
+
+} // namespace strreg
+
+#endif // STRREG_YEARS_H